@@ -1,26 +1,37 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <stack>
 #include <vector>
 
-auto Brandes(const std::vector<int>& row_pointer, const std::vector<int>& column_index)
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "rng.hpp"
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Brandes(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
 {
-  const auto         num_nodes = row_pointer.size() - 1;
+  const auto*        row_pointer  = graph.row_ptr();
+  const auto*        column_index = graph.col_idx();
+  const auto         num_nodes    = graph.num_nodes();
   std::vector<float> betweenness(num_nodes, 0.0f);
   //For each vertex s, perform a BFS to establish levels and parents
   //! The time complexity is O(V(V+E) + V*V) = O(V*E)
-  for(int i = 0; i < num_nodes; i++)
+  for(std::size_t i = 0; i < num_nodes; i++)
   {
     std::vector<int>   distance(num_nodes, -1);      // Initialize distance from s
     std::vector<int>   path_count(num_nodes, 0);      // Initialize path count
     std::vector<float> score(num_nodes, 0.0f);    // Dependency score for each vertex
-    std::queue<int>    path_queue;                      // BFS order
-    std::stack<int>    path_stack;                      // reverse BFS order
-    std::vector<std::vector<int>> parent(num_nodes);
+    std::queue<VertexId> path_queue;                    // BFS order
+    std::stack<VertexId> path_stack;                    // reverse BFS order
+    std::vector<std::vector<VertexId>> parent(num_nodes);
 
     distance[i]  = 0;
     path_count[i] = 1;
-    path_queue.push(i);
+    path_queue.push(static_cast<VertexId>(i));
     // BFS traversal
     // for a single source vertex, the time complexity is O(V+E),
     //! so the overall time complexity is O(V+E) for each vertex i
@@ -29,9 +40,9 @@ auto Brandes(const std::vector<int>& row_pointer, const std::vector<int>& column
       const auto source = path_queue.front();
       path_queue.pop();
       path_stack.push(source);
-      for(auto i = row_pointer[source]; i < row_pointer[source + 1]; i++)
+      for(auto j = row_pointer[source]; j < row_pointer[source + 1]; j++)
       {
-        const auto target = column_index[i];
+        const auto target = column_index[j];
         if(distance[target] < 0)
         {
           path_queue.push(target);
@@ -54,14 +65,12 @@ auto Brandes(const std::vector<int>& row_pointer, const std::vector<int>& column
       const auto curr = path_stack.top();
       path_stack.pop();
 
-      const auto prev = parent[curr];
-
       for(const auto& prev : parent[curr])    // Iterate through all parents
       {
         score[prev] +=
             (static_cast<float>(path_count[prev]) / path_count[curr]) * (1 + score[curr]);
       }
-      if(curr != i)    // if curr is not the source vertex
+      if(curr != static_cast<VertexId>(i))    // if curr is not the source vertex
       {
         betweenness[curr] += score[curr];
       }
@@ -70,17 +79,426 @@ auto Brandes(const std::vector<int>& row_pointer, const std::vector<int>& column
   return betweenness;
 }
 
-int main()
+//------------//
+// Parallel Brandes
+// One source per task, each thread owns a workspace it reuses across sources
+//------------//
+template <typename VertexId>
+struct BrandesWorkspace
+{
+  std::vector<int>      distance;      // -1 = not reached from the current source
+  std::vector<double>   path_count;    // double, path counts overflow int quickly
+  std::vector<double>   score;         // dependency score
+  std::vector<VertexId> order;         // BFS order, read backwards as the stack
+
+  explicit BrandesWorkspace(std::size_t num_nodes)
+      : distance(num_nodes, -1), path_count(num_nodes, 0.0), score(num_nodes, 0.0)
+  {
+    order.reserve(num_nodes);
+  }
+};
+
+// Computes the dependencies of a single source and hands every vertex other
+// than the source to `accumulate(vertex, dependency)`. Instead of predecessor
+// lists the backward sweep re-scans the out-edges of every vertex and keeps
+// those that go exactly one level deeper, i.e. the edges of the shortest-path
+// DAG. Only vertices in `order` were touched, so only those are reset
+// afterwards.
+template <typename VertexId, typename EdgeOffset, typename Weight, typename Accumulate>
+void brandes_from(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, const VertexId source,
+                  BrandesWorkspace<VertexId>& ws, Accumulate&& accumulate)
+{
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  auto&       distance     = ws.distance;
+  auto&       path_count   = ws.path_count;
+  auto&       score        = ws.score;
+  auto&       order        = ws.order;
+
+  distance[source]   = 0;
+  path_count[source] = 1.0;
+  order.push_back(source);
+  // forward BFS, `order` doubles as the queue
+  for(std::size_t head = 0; head < order.size(); head++)
+  {
+    const auto curr = order[head];
+    for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
+    {
+      const auto target = column_index[j];
+      if(distance[target] < 0)
+      {
+        order.push_back(target);
+        distance[target] = distance[curr] + 1;
+      }
+      if(distance[target] == distance[curr] + 1)
+      {
+        path_count[target] += path_count[curr];
+      }
+    }
+  }
+  // backward sweep in reverse BFS order
+  for(auto it = order.rbegin(); it != order.rend(); ++it)
+  {
+    const auto curr = *it;
+    double     dependency = 0.0;
+    for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
+    {
+      const auto target = column_index[j];
+      if(distance[target] == distance[curr] + 1)
+      {
+        dependency += path_count[curr] / path_count[target] * (1.0 + score[target]);
+      }
+    }
+    score[curr] = dependency;
+    if(curr != source)
+    {
+      accumulate(curr, dependency);
+    }
+  }
+  // sparse reset
+  for(const auto v : order)
+  {
+    distance[v]   = -1;
+    path_count[v] = 0.0;
+    score[v]      = 0.0;
+  }
+  order.clear();
+}
+
+//! The time complexity is still O(V*E), now split across threads with no
+//! allocation inside the source loop
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto ParallelBrandes(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  const auto         num_nodes = graph.num_nodes();
+  std::vector<float> betweenness(num_nodes, 0.0f);
+#pragma omp parallel
+  {
+    BrandesWorkspace<VertexId> ws(num_nodes);
+    std::vector<float>         local(num_nodes, 0.0f);    // this thread's partial sums
+#pragma omp for schedule(dynamic, 1) nowait
+    for(int64_t i = 0; i < static_cast<int64_t>(num_nodes); i++)
+    {
+      brandes_from(graph, static_cast<VertexId>(i), ws, [&local](VertexId v, double dependency) {
+        local[v] += static_cast<float>(dependency);
+      });
+    }
+    // reduce the per-thread sums
+#pragma omp critical
+    for(std::size_t v = 0; v < num_nodes; v++)
+    {
+      betweenness[v] += local[v];
+    }
+  }
+  return betweenness;
+}
+
+//------------//
+// Approximate Brandes
+// Estimate betweenness from a sample instead of all V sources
+//------------//
+enum class BCSampling
+{
+  Uniform,                 // Brandes-Pich: full dependency accumulation from random pivots
+  RiondatoKornaropoulos    // one random shortest path between a random vertex pair per sample
+};
+
+struct ApproxBCOptions
+{
+  BCSampling  sampling        = BCSampling::Uniform;
+  double      epsilon         = 0.01;    // absolute error on betweenness normalized to [0, 1]
+  double      delta           = 0.1;     // probability that some vertex misses epsilon
+  uint64_t    seed            = 0;
+  std::size_t vertex_diameter = 0;       // RK only; 0 = bound it by BFS, valid for undirected graphs
+};
+
+template <typename VertexId>
+struct ApproxBC
+{
+  std::vector<float> betweenness;    // on the same scale as Brandes()
+  std::size_t        samples;        // samples drawn before the bound was met
+};
+
+// Upper bound on the number of vertices of any shortest path: the vertex
+// diameter of each component is at most 2 * eccentricity + 1 of any vertex in it
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::size_t vertex_diameter_bound(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  const auto*           row_pointer  = graph.row_ptr();
+  const auto*           column_index = graph.col_idx();
+  const auto            num_nodes    = graph.num_nodes();
+  std::vector<int>      distance(num_nodes, -1);
+  std::vector<VertexId> order;
+  std::size_t           bound = 1;
+  for(std::size_t root = 0; root < num_nodes; root++)
+  {
+    if(distance[root] >= 0)
+    {
+      continue;
+    }
+    order.assign(1, static_cast<VertexId>(root));
+    distance[root] = 0;
+    for(std::size_t head = 0; head < order.size(); head++)
+    {
+      const auto curr = order[head];
+      for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
+      {
+        if(distance[column_index[j]] < 0)
+        {
+          distance[column_index[j]] = distance[curr] + 1;
+          order.push_back(column_index[j]);
+        }
+      }
+    }
+    bound = std::max<std::size_t>(bound, 2 * distance[order.back()] + 1);
+  }
+  return bound;
+}
+
+// RK sample: a uniform random shortest path between a random pair (s, t).
+// Calls mark(v) for every interior vertex of the path. The path is drawn
+// backwards from t, picking the predecessor u of w with probability
+// path_count[u] / path_count[w]; predecessors are found among the previous BFS
+// level, so no in-edges are needed.
+template <typename VertexId, typename EdgeOffset, typename Weight, typename Mark>
+void sample_shortest_path(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, SplitMix64& rng,
+                          BrandesWorkspace<VertexId>& ws, std::vector<std::size_t>& level_start, Mark&& mark)
+{
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto  num_nodes    = graph.num_nodes();
+  auto&       distance     = ws.distance;
+  auto&       path_count   = ws.path_count;
+  auto&       order        = ws.order;
+
+  const auto source = static_cast<VertexId>(rng.next_below(num_nodes));
+  auto       target = static_cast<VertexId>(rng.next_below(num_nodes - 1));
+  if(target >= source)
+  {
+    target++;
+  }
+
+  distance[source]   = 0;
+  path_count[source] = 1.0;
+  order.push_back(source);
+  level_start.assign(1, 0);
+  // forward BFS, stops once the level of target is complete
+  for(std::size_t head = 0; head < order.size(); head++)
+  {
+    const auto curr = order[head];
+    if(distance[curr] == static_cast<int>(level_start.size()))
+    {
+      level_start.push_back(head);
+    }
+    if(distance[target] >= 0 && distance[curr] >= distance[target])
+    {
+      break;
+    }
+    for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
+    {
+      const auto next = column_index[j];
+      if(distance[next] < 0)
+      {
+        order.push_back(next);
+        distance[next] = distance[curr] + 1;
+      }
+      if(distance[next] == distance[curr] + 1)
+      {
+        path_count[next] += path_count[curr];
+      }
+    }
+  }
+  // backward walk
+  if(distance[target] > 0)
+  {
+    auto curr = target;
+    while(distance[curr] > 1)
+    {
+      const auto level = distance[curr] - 1;
+      double     pick  = rng.next_double() * path_count[curr];
+      auto       prev  = curr;
+      for(auto i = level_start[level]; i < level_start[level + 1] && prev == curr; i++)
+      {
+        const auto candidate = order[i];
+        for(auto j = row_pointer[candidate]; j < row_pointer[candidate + 1]; j++)
+        {
+          if(column_index[j] == curr && (pick -= path_count[candidate]) < 0)
+          {
+            prev = candidate;
+            break;
+          }
+        }
+      }
+      if(prev == curr)    // rounding left pick >= 0, take the last predecessor
+      {
+        for(auto i = level_start[level]; i < level_start[level + 1]; i++)
+        {
+          for(auto j = row_pointer[order[i]]; j < row_pointer[order[i] + 1]; j++)
+          {
+            prev = column_index[j] == curr ? order[i] : prev;
+          }
+        }
+      }
+      curr = prev;
+      mark(curr);
+    }
+  }
+  for(const auto v : order)
+  {
+    distance[v]   = -1;
+    path_count[v] = 0.0;
+  }
+  order.clear();
+}
+
+// Every sample gives each vertex a value X in [0, 1] whose mean is its
+// normalized betweenness. Samples are drawn in doubling batches; after each
+// batch the empirical Bernstein bound
+//     sqrt(2 Var[X] ln(3 / d) / k) + 3 ln(3 / d) / k
+// is checked for every vertex and sampling stops once all are within epsilon.
+// Half of delta is spread over these checks, the other half backs the
+// worst-case sample size at which sampling stops regardless:
+//     Uniform  ln(4V / delta) / (2 epsilon^2)                            (Hoeffding)
+//     RK       (floor(log2(VD - 2)) + 1 + ln(2 / delta)) / (2 epsilon^2) (Riondato-Kornaropoulos)
+template <typename VertexId, typename EdgeOffset, typename Weight>
+ApproxBC<VertexId> ApproxBrandes(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, ApproxBCOptions options = {})
+{
+  const auto         num_nodes = graph.num_nodes();
+  ApproxBC<VertexId> result{ std::vector<float>(num_nodes, 0.0f), 0 };
+  if(num_nodes < 3)
+  {
+    return result;
+  }
+  const bool   uniform = options.sampling == BCSampling::Uniform;
+  const double eps2    = options.epsilon * options.epsilon;
+  std::size_t  max_samples;
+  if(uniform)
+  {
+    max_samples = std::ceil(std::log(4.0 * num_nodes / options.delta) / (2 * eps2));
+  }
+  else
+  {
+    const auto vd = options.vertex_diameter ? options.vertex_diameter : vertex_diameter_bound(graph);
+    const auto log_vd = vd > 3 ? std::floor(std::log2(vd - 2.0)) : 0.0;
+    max_samples = std::ceil((log_vd + 1 + std::log(2.0 / options.delta)) / (2 * eps2));
+  }
+  const std::size_t first_batch = 64;
+  const int         num_checks  = std::max(1.0, std::ceil(std::log2(double(max_samples) / first_batch)));
+  const double      log_term    = std::log(3.0 * num_nodes * num_checks / (options.delta / 2));
+  // a per-source dependency is at most V - 2
+  const double      scale_x     = uniform ? 1.0 / (num_nodes - 2) : 1.0;
+
+  struct ThreadState
+  {
+    BrandesWorkspace<VertexId> ws;
+    std::vector<std::size_t>   level_start;
+    std::vector<double>        sum;
+    std::vector<double>        sum_squares;
+    explicit ThreadState(std::size_t n) : ws(n), sum(n, 0.0), sum_squares(n, 0.0) {}
+  };
+  std::vector<ThreadState> states;
+  for(int t = 0; t < num_threads(); t++)
+  {
+    states.emplace_back(num_nodes);
+  }
+  std::vector<double> sum(num_nodes), sum_squares(num_nodes);
+
+  std::size_t taken = 0;
+  for(std::size_t batch_end = first_batch; taken < max_samples; batch_end *= 2)
+  {
+    batch_end = std::min(batch_end, max_samples);
+#pragma omp parallel for schedule(dynamic, 1)
+    for(int64_t i = taken; i < static_cast<int64_t>(batch_end); i++)
+    {
+      auto&      state = states[thread_id()];
+      SplitMix64 rng(options.seed, i);
+      if(uniform)
+      {
+        const auto source = static_cast<VertexId>(rng.next_below(num_nodes));
+        brandes_from(graph, source, state.ws, [&state, scale_x](VertexId v, double dependency) {
+          const double x = dependency * scale_x;
+          state.sum[v] += x;
+          state.sum_squares[v] += x * x;
+        });
+      }
+      else
+      {
+        sample_shortest_path(graph, rng, state.ws, state.level_start, [&state](VertexId v) {
+          state.sum[v] += 1.0;
+          state.sum_squares[v] += 1.0;
+        });
+      }
+    }
+    taken = batch_end;
+
+    double worst = 0.0;
+#pragma omp parallel for reduction(max : worst)
+    for(int64_t v = 0; v < static_cast<int64_t>(num_nodes); v++)
+    {
+      sum[v] = sum_squares[v] = 0.0;
+      for(const auto& state : states)
+      {
+        sum[v] += state.sum[v];
+        sum_squares[v] += state.sum_squares[v];
+      }
+      const double mean     = sum[v] / taken;
+      const double variance = std::max(0.0, sum_squares[v] / taken - mean * mean);
+      worst = std::max(worst, std::sqrt(2 * variance * log_term / taken) + 3 * log_term / taken);
+    }
+    if(worst <= options.epsilon)
+    {
+      break;
+    }
+  }
+
+  // back from normalized [0, 1] to the scale of Brandes()
+  const double scale = uniform ? double(num_nodes) * (num_nodes - 2) : double(num_nodes) * (num_nodes - 1);
+  for(std::size_t v = 0; v < num_nodes; v++)
+  {
+    result.betweenness[v] = static_cast<float>(sum[v] / taken * scale);
+  }
+  result.samples = taken;
+  return result;
+}
+
+int main(int argc, char** argv)
 {
   std::vector<int> row_pointer = { 0, 1, 3, 6, 9, 11, 12 };
   std::vector<int> column_index = { 1, 0, 2, 3, 1, 2, 4, 2, 3, 4, 5, 4 };
-  // Compute betweenness centrality using Brandes's algorithm
   // unweighted graph for simplicity
-  auto betweenness = Brandes(row_pointer, column_index);
+  CSRGraph<> graph(row_pointer, column_index);
+  // or load a binary CSR file written by write_csr()
+  if(argc > 1)
+  {
+    graph = load_csr<int, int>(argv[1]);
+  }
+  // Compute betweenness centrality using Brandes's algorithm
+  auto betweenness = Brandes(graph);
   // Print betweenness centrality
   std::cout << "Betweenness centrality:" << std::endl;
-  for(int i = 0; i < betweenness.size(); i++)
+  for(size_t i = 0; i < betweenness.size(); i++)
+  {
+    std::cout << "Vertex " << i << ": " << betweenness[i] << std::endl;
+  }
+  // the same scores, computed in parallel
+  betweenness = ParallelBrandes(graph);
+  std::cout << "Parallel betweenness centrality:" << std::endl;
+  for(size_t i = 0; i < betweenness.size(); i++)
   {
     std::cout << "Vertex " << i << ": " << betweenness[i] << std::endl;
   }
+  // estimates within 5% of the normalized scores, with probability 90%
+  ApproxBCOptions options;
+  options.epsilon = 0.05;
+  for(auto sampling : { BCSampling::Uniform, BCSampling::RiondatoKornaropoulos })
+  {
+    options.sampling = sampling;
+    auto approx      = ApproxBrandes(graph, options);
+    std::cout << (sampling == BCSampling::Uniform ? "Uniform" : "Riondato-Kornaropoulos")
+              << " estimate from " << approx.samples << " samples:" << std::endl;
+    for(size_t i = 0; i < approx.betweenness.size(); i++)
+    {
+      std::cout << "Vertex " << i << ": " << approx.betweenness[i] << std::endl;
+    }
+  }
 }
\ No newline at end of file
@@ -1,60 +1,450 @@
+#include <algorithm>
 #include <iostream>
-#include <stack>
+#include <utility>
 #include <vector>
-// https://github.com/WarriorsSami/Tarjan/blob/master/tarjan.cpp
-std::vector<std::vector<int>> tarjan(const std::vector<int> &row_ptr,
-                                     const std::vector<int> &col_idx) {
-    const auto num_vertices = row_ptr.size() - 1;
-    std::vector<int> discovery_time(num_vertices, -1);
-    std::vector<int> low_time(num_vertices, -1);
-    std::vector<int> parent(num_vertices, -1);
-    std::vector<bool> visited(num_vertices, false);
-    std::stack<int> node_stack;
-    std::vector<std::vector<int>> bcc;
-    int depth = 0;
-
-    auto dfs = [&](int source, auto &&dfs_ref) -> void {
-        low_time[source] = discovery_time[source] = depth++;
-        visited[source] = true;
-        node_stack.push(source);
-        int num_children = 0;
-
-        for (int i = row_ptr[source]; i < row_ptr[source + 1]; i++) {
-            int target = col_idx[i];
-            if (visited[target]) {
-                low_time[source] =
-                    std::min(low_time[source], discovery_time[target]);
-            } else {
-                num_children++;
-                parent[target] = source;
-                dfs_ref(target, dfs_ref);
-                low_time[source] = std::min(low_time[source], low_time[target]);
-                // a source node is an articulation point if
-                // 1. it is root && has more than 1 child
-                // 2. not root && low_time of any of its children is
-                // greater than or equal to discovery_time of the source node
-                if ((parent[source] == -1 && num_children > 1) ||
-                    (parent[source] &&
-                     low_time[target] >= discovery_time[source])) {
-                    std::vector<int> component;
-                    while (node_stack.top() != target) {
-                        component.push_back(node_stack.top());
-                        node_stack.pop();
-                    }
-                    // component.push_back(node_stack.top());  // get the target
-                    node_stack.pop();
-                    component.push_back(source);  // get the source
-                    bcc.push_back(component);
+
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "graph_builder.hpp"
+#include "parallel.hpp"
+#include "union_find.hpp"
+
+/********************
+ * Blocks, articulation points, bridges and the block-cut tree
+ ********************/
+// Biconnected components (blocks) of an undirected graph. Isolated vertices
+// belong to no block.
+template <typename VertexId, typename EdgeOffset>
+struct BiconnectedComponents {
+    // vertices of block b: block_vertices[block_ptr[b], block_ptr[b + 1])
+    std::vector<EdgeOffset> block_ptr{0};
+    std::vector<VertexId> block_vertices;
+    std::vector<VertexId> articulation_points;  // sorted
+    std::vector<std::pair<VertexId, VertexId>> bridges;
+    // nodes [0, num_blocks()) are the blocks, num_blocks() + k is
+    // articulation_points[k]; a block and a cut vertex are adjacent when the
+    // vertex lies in the block
+    CSRGraph<VertexId, EdgeOffset> block_cut_tree;
+
+    std::size_t num_blocks() const { return block_ptr.size() - 1; }
+};
+
+// Fills articulation_points and block_cut_tree from the blocks and the flags
+template <typename VertexId, typename EdgeOffset>
+void finish_block_cut_tree(BiconnectedComponents<VertexId, EdgeOffset> &result,
+                           const std::vector<bool> &is_cut) {
+    const std::size_t num_nodes = is_cut.size();
+    const std::size_t num_blocks = result.num_blocks();
+    std::vector<VertexId> cut_rank(num_nodes, 0);
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        if (is_cut[v]) {
+            cut_rank[v] = static_cast<VertexId>(result.articulation_points.size());
+            result.articulation_points.push_back(static_cast<VertexId>(v));
+        }
+    }
+    EdgeList<VertexId> edges;
+    edges.num_nodes = num_blocks + result.articulation_points.size();
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        for (auto i = result.block_ptr[b]; i < result.block_ptr[b + 1]; i++) {
+            const auto v = result.block_vertices[i];
+            if (is_cut[v]) {
+                edges.sources.push_back(static_cast<VertexId>(b));
+                edges.targets.push_back(
+                    static_cast<VertexId>(num_blocks + cut_rank[v]));
+            }
+        }
+    }
+    BuildOptions options;
+    options.symmetrize = true;
+    options.sort_neighbors = true;
+    result.block_cut_tree = build_csr<EdgeOffset>(edges, options);
+}
+
+/********************
+ * Hopcroft-Tarjan with an edge stack
+ ********************/
+// Iterative DFS: the call stack holds (vertex, next edge) frames and every
+// tree or back edge goes on an edge stack. When a child v finishes with
+// low[v] >= disc[parent], the edges above (parent, v) form one block. Only
+// the single edge a vertex was entered by is skipped, so parallel edges
+// correctly form a block of their own instead of a bridge.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto hopcroft_tarjan(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    constexpr auto invalid =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const std::size_t num_vertices = graph.num_nodes();
+    std::vector<VertexId> discovery_time(num_vertices, invalid);
+    std::vector<VertexId> low_time(num_vertices, 0);
+    std::vector<bool> is_cut(num_vertices, false);
+    std::vector<VertexId> in_block(num_vertices, invalid);  // last block seen
+    struct Frame {
+        VertexId vertex;
+        VertexId parent;
+        EdgeOffset next_edge;
+        bool parent_skipped;  // the entering edge has been passed over
+        VertexId num_children;
+    };
+    std::vector<Frame> call_stack;
+    std::vector<std::pair<VertexId, VertexId>> edge_stack;
+    BiconnectedComponents<VertexId, EdgeOffset> result;
+    VertexId depth = 0;
+
+    // pops edges up to and including (parent, child) into a new block
+    auto pop_block = [&](VertexId parent, VertexId child) {
+        const auto block = static_cast<VertexId>(result.num_blocks());
+        std::size_t num_edges = 0;
+        while (true) {
+            const auto [u, w] = edge_stack.back();
+            edge_stack.pop_back();
+            num_edges++;
+            for (auto x : {u, w}) {
+                if (in_block[x] != block) {
+                    in_block[x] = block;
+                    result.block_vertices.push_back(x);
+                }
+            }
+            if (u == parent && w == child) {
+                break;
+            }
+        }
+        result.block_ptr.push_back(result.block_vertices.size());
+        if (num_edges == 1) {
+            result.bridges.emplace_back(std::min(parent, child),
+                                        std::max(parent, child));
+        }
+    };
+
+    for (std::size_t start = 0; start < num_vertices; start++) {
+        if (discovery_time[start] != invalid) {
+            continue;
+        }
+        const auto root = static_cast<VertexId>(start);
+        low_time[root] = discovery_time[root] = depth++;
+        call_stack.push_back({root, invalid, row_ptr[root], true, 0});
+        while (!call_stack.empty()) {
+            auto &frame = call_stack.back();
+            const auto source = frame.vertex;
+            if (frame.next_edge < row_ptr[source + 1]) {
+                const auto target = col_idx[frame.next_edge++];
+                if (target == source) {
+                    continue;  // self loops do not affect connectivity
                 }
+                if (target == frame.parent && !frame.parent_skipped) {
+                    frame.parent_skipped = true;
+                    continue;
+                }
+                if (discovery_time[target] == invalid) {
+                    frame.num_children++;
+                    edge_stack.emplace_back(source, target);
+                    low_time[target] = discovery_time[target] = depth++;
+                    call_stack.push_back(
+                        {target, source, row_ptr[target], false, 0});
+                } else if (discovery_time[target] < discovery_time[source]) {
+                    // back edge to an ancestor; seen from the ancestor the
+                    // same edge leads to a finished descendant and is ignored
+                    edge_stack.emplace_back(source, target);
+                    low_time[source] =
+                        std::min(low_time[source], discovery_time[target]);
+                }
+                continue;
+            }
+            //>> Finish source
+            const auto child = source;
+            const auto child_low = low_time[child];
+            const auto num_children = frame.num_children;
+            call_stack.pop_back();
+            if (call_stack.empty()) {
+                // the root is a cut vertex iff it has two or more children
+                is_cut[child] = num_children > 1;
+                break;
             }
+            auto &parent_frame = call_stack.back();
+            const auto parent = parent_frame.vertex;
+            low_time[parent] = std::min(low_time[parent], child_low);
+            if (child_low >= discovery_time[parent]) {
+                if (parent_frame.parent != invalid) {
+                    is_cut[parent] = true;
+                }
+                pop_block(parent, child);
+            }
+        }
+    }
+    finish_block_cut_tree(result, is_cut);
+    return result;
+}
+
+/********************
+ * Tarjan-Vishkin (parallel)
+ ********************/
+// Tarjan & Vishkin, "An efficient parallel biconnectivity algorithm" (1985).
+// Any rooted spanning forest works, so it is built from parallel pieces:
+//   1. connectivity with the lock-free union-find; every component is rooted
+//      at its smallest vertex
+//   2. a multi-source BFS from all roots at once gives the forest and its
+//      levels, which order the bottom-up and top-down passes below
+//   3. per vertex: subtree size nd, preorder number pre, and low / high, the
+//      extreme pre reachable from the subtree through one non-tree edge
+//   4. tree edge (parent[v], v) is named by v. Two of them lie in the same
+//      block iff they are connected in the auxiliary graph with
+//        - e(v) ~ e(w) for a non-tree edge v - w between unrelated vertices
+//        - e(v) ~ e(p), p = parent[v] not a root, if some non-tree edge
+//          leaves the subtree of p from the subtree of v:
+//          low[v] < pre[p] or high[v] >= pre[p] + nd[p]
+//      found with the union-find again.
+// Blocks come out with sorted vertices, in the order of their smallest tree
+// edge. The graph must be simple and undirected: a parallel edge is taken for
+// its tree edge, so a doubled bridge is still reported as a bridge.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto tarjan_vishkin(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    constexpr auto invalid =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const std::size_t num_vertices = graph.num_nodes();
+
+    //>> 1. Connectivity
+    std::vector<VertexId> comp(num_vertices);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        comp[v] = static_cast<VertexId>(v);
+    }
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t u = 0; u < num_vertices; u++) {
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            union_find_link(static_cast<VertexId>(u), col_idx[i], comp.data());
+        }
+    }
+    union_find_compress(num_vertices, comp.data());
+
+    //>> 2. BFS forest from every component root; roots are their own parent
+    std::vector<VertexId> parent(num_vertices, invalid);
+    std::vector<std::vector<VertexId>> levels(1);
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        if (comp[v] == static_cast<VertexId>(v)) {
+            parent[v] = static_cast<VertexId>(v);
+            levels[0].push_back(static_cast<VertexId>(v));
+        }
+    }
+    std::vector<VertexId>().swap(comp);
+    // a level runs in parallel only when it is worth a fork-join; a deep
+    // forest (road or infrastructure networks) has millions of tiny levels
+    auto for_level = [](const std::vector<VertexId> &level, auto f) {
+        if (level.size() > 1024) {
+#pragma omp parallel for schedule(dynamic, 256)
+            for (std::size_t k = 0; k < level.size(); k++) {
+                f(level[k]);
+            }
+        } else {
+            for (auto v : level) {
+                f(v);
+            }
+        }
+    };
+    while (true) {
+        std::vector<VertexId> next;
+        const auto &frontier = levels.back();
+        auto expand = [&](VertexId u, std::vector<VertexId> &out) {
+            for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+                const auto w = col_idx[i];
+                if (atomic_load(parent[w]) == invalid &&
+                    compare_and_swap(parent[w], invalid, u)) {
+                    out.push_back(w);
+                }
+            }
+        };
+        if (frontier.size() > 256) {
+#pragma omp parallel
+            {
+                std::vector<VertexId> local;
+#pragma omp for schedule(dynamic, 64) nowait
+                for (std::size_t f = 0; f < frontier.size(); f++) {
+                    expand(frontier[f], local);
+                }
+#pragma omp critical
+                next.insert(next.end(), local.begin(), local.end());
+            }
+        } else {
+            for (auto u : frontier) {
+                expand(u, next);
+            }
+        }
+        if (next.empty()) {
+            break;
         }
+        levels.push_back(std::move(next));
+    }
+    auto is_root = [&](VertexId v) { return parent[v] == v; };
+
+    // children lists of the forest
+    std::vector<EdgeOffset> num_children(num_vertices, 0);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        if (!is_root(v)) {
+            fetch_and_add(num_children[parent[v]], EdgeOffset(1));
+        }
+    }
+    const std::vector<EdgeOffset> child_ptr =
+        prefix_sum<EdgeOffset>(num_children);
+    std::vector<VertexId> children(child_ptr[num_vertices]);
+    std::vector<EdgeOffset> cursor(child_ptr.begin(), child_ptr.end() - 1);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        if (!is_root(v)) {
+            children[fetch_and_add(cursor[parent[v]], EdgeOffset(1))] =
+                static_cast<VertexId>(v);
+        }
+    }
+    std::vector<EdgeOffset>().swap(cursor);
+    std::vector<EdgeOffset>().swap(num_children);
+
+    //>> 3. nd, low, high bottom-up; pre top-down
+    std::vector<VertexId> nd(num_vertices), pre(num_vertices);
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        for_level(*level, [&](VertexId v) {
+            VertexId size = 1;
+            for (auto c = child_ptr[v]; c < child_ptr[v + 1]; c++) {
+                size += nd[children[c]];
+            }
+            nd[v] = size;
+        });
+    }
+    for (const auto &level : levels) {
+        for_level(level, [&](VertexId v) {
+            if (is_root(v)) {
+                pre[v] = 0;
+            }
+            VertexId next_pre = pre[v] + 1;
+            for (auto c = child_ptr[v]; c < child_ptr[v + 1]; c++) {
+                pre[children[c]] = next_pre;
+                next_pre += nd[children[c]];
+            }
+        });
+    }
+    auto is_tree_edge = [&](VertexId v, VertexId w) {
+        return (parent[v] == w && !is_root(v)) ||
+               (parent[w] == v && !is_root(w));
     };
-    for (int i = 0; i < num_vertices; ++i) {
-        dfs(i, dfs);
+    std::vector<VertexId> low(num_vertices), high(num_vertices);
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        for_level(*level, [&](VertexId v) {
+            VertexId lo = pre[v], hi = pre[v];
+            for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                const auto w = col_idx[i];
+                if (w != v && !is_tree_edge(v, w)) {
+                    lo = std::min(lo, pre[w]);
+                    hi = std::max(hi, pre[w]);
+                }
+            }
+            for (auto c = child_ptr[v]; c < child_ptr[v + 1]; c++) {
+                lo = std::min(lo, low[children[c]]);
+                hi = std::max(hi, high[children[c]]);
+            }
+            low[v] = lo;
+            high[v] = hi;
+        });
+    }
+
+    //>> 4. Auxiliary graph over tree edges
+    auto is_ancestor = [&](VertexId a, VertexId b) {
+        return pre[a] <= pre[b] && pre[b] < pre[a] + nd[a];
+    };
+    std::vector<VertexId> block_of(num_vertices);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        block_of[v] = static_cast<VertexId>(v);
     }
-    return bcc;
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        const auto u = static_cast<VertexId>(v);
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            const auto w = col_idx[i];
+            if (u < w && !is_tree_edge(u, w) && !is_ancestor(u, w) &&
+                !is_ancestor(w, u)) {
+                union_find_link(u, w, block_of.data());
+            }
+        }
+        if (is_root(u) || is_root(parent[u])) {
+            continue;
+        }
+        const auto p = parent[u];
+        if (low[u] < pre[p] || high[u] >= pre[p] + nd[p]) {
+            union_find_link(u, p, block_of.data());
+        }
+    }
+    union_find_compress(num_vertices, block_of.data());
+    std::vector<VertexId>().swap(low);
+    std::vector<VertexId>().swap(high);
+
+    //>> Blocks: the children of its tree edges plus one head on top
+    BiconnectedComponents<VertexId, EdgeOffset> result;
+    std::vector<EdgeOffset> is_block(num_vertices);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        is_block[v] = !is_root(v) && block_of[v] == static_cast<VertexId>(v);
+    }
+    const std::vector<EdgeOffset> block_id = prefix_sum<EdgeOffset>(is_block);
+    const std::size_t num_blocks = block_id[num_vertices];
+    std::vector<EdgeOffset>().swap(is_block);
+    std::vector<EdgeOffset> block_size(num_blocks, 1);  // the head
+    std::vector<VertexId> head(num_blocks, 0);  // head + 1, 0 until found
+    std::vector<VertexId> heads_of(num_vertices, 0);  // blocks v is head of
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        if (is_root(v)) {
+            continue;
+        }
+        const auto b = block_id[block_of[v]];
+        fetch_and_add(block_size[b], EdgeOffset(1));
+        // the topmost tree edges of a block are those whose parent is not
+        // itself entered by an edge of the block
+        const auto p = parent[v];
+        if (is_root(p) || block_of[p] != block_of[v]) {
+            if (compare_and_swap(head[b], VertexId(0), VertexId(p + 1))) {
+                fetch_and_add(heads_of[p], VertexId(1));
+            }
+        }
+    }
+    result.block_ptr = prefix_sum<EdgeOffset>(block_size);
+    result.block_vertices.resize(result.block_ptr[num_blocks]);
+    std::vector<EdgeOffset> fill(result.block_ptr.begin(),
+                                 result.block_ptr.end() - 1);
+#pragma omp parallel for
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        result.block_vertices[fill[b]++] = head[b] - 1;
+    }
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        if (!is_root(v)) {
+            const auto b = block_id[block_of[v]];
+            result.block_vertices[fetch_and_add(fill[b], EdgeOffset(1))] =
+                static_cast<VertexId>(v);
+        }
+    }
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        std::sort(result.block_vertices.begin() + result.block_ptr[b],
+                  result.block_vertices.begin() + result.block_ptr[b + 1]);
+    }
+
+    //>> Cut vertices head a block and lie in another one
+    std::vector<bool> is_cut(num_vertices, false);
+    for (std::size_t v = 0; v < num_vertices; v++) {
+        is_cut[v] = heads_of[v] >= (is_root(v) ? 2 : 1);
+    }
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        if (block_size[b] == 2) {
+            const auto u = result.block_vertices[result.block_ptr[b]];
+            const auto w = result.block_vertices[result.block_ptr[b] + 1];
+            result.bridges.emplace_back(u, w);
+        }
+    }
+    finish_block_cut_tree(result, is_cut);
+    return result;
 }
-int main() {
+
+int main(int argc, char **argv) {
     /**
      * @brief Graph Visualization:
         0 --- 1
@@ -67,15 +457,39 @@ int main() {
      */
     std::vector<int> row_ptr = {0, 2, 4, 7, 10, 12, 14};
     std::vector<int> col_idx = {1, 2, 0, 2, 0, 1, 3, 2, 4, 5, 3, 5, 3, 4};
+    CSRGraph<> graph(row_ptr, col_idx);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
 
-    auto BCCs = tarjan(row_ptr, col_idx);
-    std::cout << "--------------------------\n";
-
-    for (auto &component : BCCs) {
-        for (auto &vertex : component) {
-            std::cout << vertex << " ";
+    for (const auto &bcc : {hopcroft_tarjan(graph), tarjan_vishkin(graph)}) {
+        std::cout << "--------------------------\n";
+        for (std::size_t b = 0; b < bcc.num_blocks(); b++) {
+            std::cout << "block " << b << ": ";
+            for (auto i = bcc.block_ptr[b]; i < bcc.block_ptr[b + 1]; i++) {
+                std::cout << bcc.block_vertices[i] << " ";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "articulation points: ";
+        for (auto v : bcc.articulation_points) {
+            std::cout << v << " ";
+        }
+        std::cout << "\nbridges: ";
+        for (auto [u, v] : bcc.bridges) {
+            std::cout << u << "-" << v << " ";
+        }
+        std::cout << "\nblock-cut tree edges: ";
+        const auto &tree = bcc.block_cut_tree;
+        for (std::size_t x = 0; x < tree.num_nodes(); x++) {
+            for (auto y : tree.neighbors(x)) {
+                if (x < static_cast<std::size_t>(y)) {
+                    std::cout << x << "-" << y << " ";
+                }
+            }
         }
         std::cout << std::endl;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -1,81 +1,202 @@
+#include <cstdint>
 #include <iostream>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
-#include <queue>
 #include <stack>
 
-std::stack<int> BFS(const int root, const int target, const std::vector<int>& row_pointer, const std::vector<int>& column_index) {
-   
-    std::unordered_map<int, int> parent;
-    std::unordered_set<int> visited;
-    std::queue<int> nodeQue;  // std::stack<int> nodeStk for DFS
-    std::stack<int> path;
-    bool hasFound = false;
+#include "bitmap.hpp"
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "transpose.hpp"
 
-    nodeQue.push(root);
-    visited.insert(root);
+/*
+Direction-optimizing BFS (Beamer, Asanovic, Patterson, SC'12)
 
-    while(!nodeQue.empty()) {
-        auto curr = nodeQue.front();  // nodeStk.top() for DFS
-        nodeQue.pop();
+Top-down steps expand a sparse frontier (a vertex list): every frontier vertex
+claims its unvisited neighbors with a compare-and-swap on `depth`.
+Bottom-up steps use a bitmap frontier: every unvisited vertex scans its
+in-neighbors and stops at the first one found in the frontier. On power-law
+graphs the few middle levels touch most edges, and bottom-up skips most of
+them. The switch follows the paper's heuristic:
+    top-down -> bottom-up  when the frontier's out-edges > unexplored edges / alpha
+    bottom-up -> top-down  when the frontier shrinks below num_nodes / beta
 
-        if(curr == target) {
-            hasFound = true;
-            break;
-        }
+`transpose` supplies the in-edges for the bottom-up steps; for an undirected
+(symmetric) graph it is the graph itself. Without it every step is top-down.
+ */
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<VertexId> DOBFS(const VertexId root, const CSRGraph<VertexId, EdgeOffset, Weight>& graph,
+                            const CSRGraph<VertexId, EdgeOffset, Weight>* transpose,
+                            const VertexId target = CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex) {
+    constexpr auto invalid = CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    constexpr int alpha = 15;
+    constexpr int beta = 18;
+    const auto* row_pointer = graph.row_ptr();
+    const auto* column_index = graph.col_idx();
+    const int64_t num_nodes = graph.num_nodes();
+
+    std::vector<VertexId> parent(num_nodes, invalid);
+    std::vector<int> depth(num_nodes, -1);
+    std::vector<VertexId> frontier{root};  // sparse frontier
+    Bitmap front(num_nodes);               // dense frontier
+    Bitmap next(num_nodes);
+    parent[root] = root;
+    depth[root] = 0;
 
-        for(int i = row_pointer[curr]; i < row_pointer[curr+1]; i++) {
-            auto next = column_index[i];
-            if(visited.count(next) == 0)
-            {   
-                nodeQue.push(next);
-                visited.insert(next);
-                parent[next] = curr;
+    int level = 0;
+    int64_t edges_to_check = graph.num_edges();
+    int64_t scout_count = graph.degree(root);
+    while(!frontier.empty()) {
+        if(target != invalid && depth[target] != -1) {
+            break;  // the path to target is complete
+        }
+        if(transpose != nullptr && scout_count > edges_to_check / alpha) {
+            //>> Bottom-up steps
+            const auto* csc_pointer = transpose->row_ptr();
+            const auto* csc_index = transpose->col_idx();
+            front.reset();
+#pragma omp parallel for
+            for(std::size_t i = 0; i < frontier.size(); i++) {
+                front.set_bit_atomic(frontier[i]);
+            }
+            int64_t awake_count = frontier.size();
+            int64_t old_awake_count;
+            do {
+                old_awake_count = awake_count;
+                awake_count = 0;
+                next.reset();
+#pragma omp parallel for reduction(+ : awake_count) schedule(dynamic, 1024)
+                for(int64_t v = 0; v < num_nodes; v++) {
+                    if(depth[v] != -1) {
+                        continue;
+                    }
+                    for(auto i = csc_pointer[v]; i < csc_pointer[v+1]; i++) {
+                        auto prev = csc_index[i];
+                        if(front.get_bit(prev)) {
+                            parent[v] = prev;
+                            depth[v] = level + 1;
+                            next.set_bit_atomic(v);
+                            awake_count++;
+                            break;
+                        }
+                    }
+                }
+                front.swap(next);
+                level++;
+            } while(awake_count > 0 && (awake_count >= old_awake_count || awake_count > num_nodes / beta)
+                    && (target == invalid || depth[target] == -1));
+            // back to a sparse frontier, gathered per thread
+            frontier.clear();
+#pragma omp parallel
+            {
+                std::vector<VertexId> local;
+#pragma omp for schedule(static, 4096) nowait
+                for(int64_t v = 0; v < num_nodes; v++) {
+                    if(front.get_bit(v)) {
+                        local.push_back(v);
+                    }
+                }
+#pragma omp critical
+                frontier.insert(frontier.end(), local.begin(), local.end());
+            }
+            scout_count = 1;
+        } else {
+            //>> Top-down step
+            edges_to_check -= scout_count;
+            scout_count = 0;
+            std::vector<VertexId> next_frontier;
+#pragma omp parallel reduction(+ : scout_count)
+            {
+                std::vector<VertexId> local;
+#pragma omp for schedule(dynamic, 64) nowait
+                for(std::size_t f = 0; f < frontier.size(); f++) {
+                    const auto curr = frontier[f];
+                    for(auto i = row_pointer[curr]; i < row_pointer[curr+1]; i++) {
+                        auto next = column_index[i];
+                        if(atomic_load(depth[next]) == -1 && compare_and_swap(depth[next], -1, level + 1)) {
+                            parent[next] = curr;
+                            local.push_back(next);
+                            scout_count += graph.degree(next);
+                        }
+                    }
+                }
+#pragma omp critical
+                next_frontier.insert(next_frontier.end(), local.begin(), local.end());
             }
+            frontier.swap(next_frontier);
+            level++;
         }
     }
+    return parent;
+}
 
-    if(hasFound) {
+// Walks the parent array back from target, root ends up on top of the stack.
+// The path is empty if target is unreachable.
+template <typename VertexId>
+std::stack<VertexId> path_to(const VertexId root, const VertexId target, const std::vector<VertexId>& parent,
+                             const VertexId invalid) {
+    std::stack<VertexId> path;
+    if(parent[target] != invalid) {
         auto curr = target;
-        path.push(curr);
-        if(curr != root) {
-            curr = parent[curr];
+        while(curr != root) {
             path.push(curr);
+            curr = parent[curr];
         }
         path.push(root);
-    } 
+    }
     return path;
 }
 
-void DFS(const int root, const int target, std::vector<int>& path, std::vector<bool>& visited, const std::vector<int>& row_pointer, const std::vector<int>& column_index) {
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::stack<VertexId> BFS(const VertexId root, const VertexId target, const CSRGraph<VertexId, EdgeOffset, Weight>& graph,
+                         const CSRGraph<VertexId, EdgeOffset, Weight>& transpose) {
+    constexpr auto invalid = CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    return path_to(root, target, DOBFS(root, graph, &transpose, target), invalid);
+}
+
+// Builds the transpose on first use and keeps it in the graph's cache.
+// An undirected graph can be passed as its own transpose to BFS() above.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::stack<VertexId> BFS(const VertexId root, const VertexId target, const CSRGraph<VertexId, EdgeOffset, Weight>& graph) {
+    return BFS(root, target, graph, transpose_of(graph));
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void DFS(const VertexId root, const VertexId target, std::vector<VertexId>& path, std::vector<bool>& visited, const CSRGraph<VertexId, EdgeOffset, Weight>& graph) {
+   const auto* row_pointer = graph.row_ptr();
+   const auto* column_index = graph.col_idx();
    visited[root] = true;
    path.push_back(root);
 
    if(root == target) {
     std::cout << "DFS path from root to target: ";
-    for(int i = 0; i < path.size(); i++) {
+    for(size_t i = 0; i < path.size(); i++) {
         std::cout << path[i] << " ";
     }
     std::cout << '\n';
    }    
-   for(int i = row_pointer[root]; i < row_pointer[root+1]; i++) {
-      int next = column_index[i];
+   for(auto i = row_pointer[root]; i < row_pointer[root+1]; i++) {
+      auto next = column_index[i];
       if( visited[next] == false ) {
-        DFS(next, target, path, visited, row_pointer, column_index);
+        DFS(next, target, path, visited, graph);
       }
     }
 }
 
 
-int main() {
+int main(int argc, char **argv) {
     
     std::vector<int> rowPointer = {0, 2, 4, 6, 8, 10, 12};
     std::vector<int> colIndices = {1, 2, 0, 3, 0, 1, 4, 1, 2, 5, 3, 5};
+    CSRGraph<> graph(rowPointer, colIndices);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
     //////////
     // BFS //
     /////////
-    auto bfs_path = BFS(0, 5, rowPointer, colIndices);
+    auto bfs_path = BFS(0, 5, graph);
 
     if(bfs_path.empty()) {
         std::cout << "Path Not Found\n";
@@ -85,22 +206,17 @@ int main() {
             std::cout << bfs_path.top() << ' ';
             bfs_path.pop();
         }
+        std::cout << '\n';
     }
     //////////
     // DFS //
     /////////
     std::vector<int> dfs_path;
-    std::vector<bool> visited( rowPointer.size()-1, false );  //used as unordered_set
-    DFS(0, 5, dfs_path, visited, rowPointer, colIndices);
+    std::vector<bool> visited( graph.num_nodes(), false );  //used as unordered_set
+    DFS(0, 5, dfs_path, visited, graph);
     
     if(dfs_path.empty()) {
         std::cout << "Path Not Found\n";
-    } else {
-        std::cout << "Path from Root to Target: ";
-        while(!dfs_path.empty())  {
-            std::cout << dfs_path.top() << ' ';
-            dfs_path.pop();
-        }
     }
 
     return 0;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+A fixed-size bit set over vertex ids, used for dense frontiers and visited
+sets. The *_atomic() members may race with each other on the same word; all
+other members must not run concurrently with writers.
+ */
+class Bitmap {
+   public:
+    explicit Bitmap(std::size_t size = 0)
+        : size_(size), words_((size + 63) / 64, 0) {}
+
+    std::size_t size() const { return size_; }
+
+    void reset() { std::fill(words_.begin(), words_.end(), 0); }
+
+    bool get_bit(std::size_t pos) const {
+        return (words_[pos / 64] >> (pos % 64)) & 1;
+    }
+
+    bool get_bit_atomic(std::size_t pos) const {
+        return (__atomic_load_n(&words_[pos / 64], __ATOMIC_RELAXED) >>
+                (pos % 64)) &
+               1;
+    }
+
+    void set_bit(std::size_t pos) { words_[pos / 64] |= uint64_t(1) << (pos % 64); }
+
+    void clear_bit(std::size_t pos) {
+        words_[pos / 64] &= ~(uint64_t(1) << (pos % 64));
+    }
+
+    void set_bit_atomic(std::size_t pos) {
+        __atomic_fetch_or(&words_[pos / 64], uint64_t(1) << (pos % 64),
+                          __ATOMIC_RELAXED);
+    }
+
+    // Sets the bit atomically, returns false if it was already set
+    bool try_set_bit_atomic(std::size_t pos) {
+        const uint64_t mask = uint64_t(1) << (pos % 64);
+        return !(__atomic_fetch_or(&words_[pos / 64], mask, __ATOMIC_RELAXED) &
+                 mask);
+    }
+
+    void swap(Bitmap &other) {
+        std::swap(size_, other.size_);
+        words_.swap(other.words_);
+    }
+
+   private:
+    std::size_t size_;
+    std::vector<uint64_t> words_;
+};
@@ -1,33 +1,47 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <numeric>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "bitmap.hpp"
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "rng.hpp"
+#include "union_find.hpp"
+
 /********************
  * DFS + Label Propagation
  ********************/
-auto dfs_cc(const std::vector<int> &row_pointer,
-            const std::vector<int> &column_index) {
-    int labelCount = 0;
-    const auto num_nodes = row_pointer.size() - 1;
-    std::vector<int> label(num_nodes, -1);
-
-    std::function<void(int)> dfs = [&dfs, &row_pointer, &column_index,
-                                    &label](int curr) {
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto dfs_cc(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    constexpr auto invalid =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    VertexId labelCount = 0;
+    std::vector<VertexId> label(num_nodes, invalid);
+
+    std::function<void(VertexId)> dfs = [&dfs, row_pointer, column_index,
+                                         &label](VertexId curr) {
         auto currentLabel = label[curr];
         for (auto i = row_pointer[curr]; i < row_pointer[curr + 1]; i++) {
             auto next = column_index[i];
-            if (label[next] == -1) {
+            if (label[next] == invalid) {
                 label[next] = currentLabel;
                 dfs(next);  // propagate the label
             }
         }
     };
 
-    for (int i = 0; i < num_nodes; i++) {
-        if (label[i] == -1) {
+    for (std::size_t i = 0; i < num_nodes; i++) {
+        if (label[i] == invalid) {
             label[i] = labelCount++;
-            dfs(i);
+            dfs(static_cast<VertexId>(i));
         }
     }
     return label;
@@ -35,16 +49,18 @@ auto dfs_cc(const std::vector<int> &row_pointer,
 /********************
  * Union-Find CC
  ********************/
-auto union_find(const std::vector<int> &row_pointer,
-                const std::vector<int> &column_index) {
-    const auto num_nodes = row_pointer.size() - 1;
-    std::vector<int> parent(num_nodes);
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto union_find(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    std::vector<VertexId> parent(num_nodes);
     std::vector<int> rank(num_nodes);  // keep tree relatively balanced
     std::iota(parent.begin(), parent.end(), 0);
     //! Find
     // the resurive find function is not very clever
     // we can use `while(parent[i] != i) { i = parent[i]; }` instead
-    std::function<int(int)> find = [&find, &parent](int i) {
+    std::function<VertexId(VertexId)> find = [&find, &parent](VertexId i) {
         if (parent[i] == i) {
             return i;
         }
@@ -55,8 +71,8 @@ auto union_find(const std::vector<int> &row_pointer,
         return parent[i];
     };
 
-    std::function<void(int, int)> unite = [&find, &parent, &rank](int i,
-                                                                  int j) {
+    std::function<void(VertexId, VertexId)> unite =
+        [&find, &parent, &rank](VertexId i, VertexId j) {
         i = find(i);
         j = find(j);
         // if(i != j)
@@ -79,9 +95,9 @@ auto union_find(const std::vector<int> &row_pointer,
         }
     };
 
-    for (int i = 0; i < num_nodes; i++) {
+    for (std::size_t i = 0; i < num_nodes; i++) {
         for (auto j = row_pointer[i]; j < row_pointer[i + 1]; j++) {
-            unite(i, column_index[j]);
+            unite(static_cast<VertexId>(i), column_index[j]);
         }
     }
     return parent;
@@ -90,10 +106,12 @@ auto union_find(const std::vector<int> &row_pointer,
 /********************
  * Shiloach-Vishkin CC
  ********************/
-auto shiloach_vishkin(const std::vector<int> &row_pointer,
-                      const std::vector<int> &column_index) {
-    const auto num_nodes = row_pointer.size() - 1;
-    std::vector<int> parent(num_nodes);  // same as parent
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto shiloach_vishkin(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    std::vector<VertexId> parent(num_nodes);  // same as parent
     std::iota(parent.begin(), parent.end(), 0);
 
     bool update = true;
@@ -101,7 +119,7 @@ auto shiloach_vishkin(const std::vector<int> &row_pointer,
         update = false;
         //? Hooking Phase
         //! allowing for parallelism
-        for (int i = 0; i < num_nodes; i++) {
+        for (std::size_t i = 0; i < num_nodes; i++) {
             auto curr_parent = parent[i];
             for (auto j = row_pointer[i]; j < row_pointer[i + 1]; j++) {
                 auto next = column_index[j];
@@ -114,7 +132,7 @@ auto shiloach_vishkin(const std::vector<int> &row_pointer,
         }
         //? Shortcutting / Compressing / Jumping Phase
         //! allowing for parallelism
-        for (int i = 0; i < num_nodes; i++) {
+        for (std::size_t i = 0; i < num_nodes; i++) {
             while (parent[i] != parent[parent[i]]) {
                 parent[i] = parent[parent[i]];
                 update = true;
@@ -124,31 +142,235 @@ auto shiloach_vishkin(const std::vector<int> &row_pointer,
     return parent;
 }
 
-int main() {
+/********************
+ * Afforest CC (Sutton, Ben-Nun, Barak 2018)
+ ********************/
+// The most frequent label among a random sample of vertices: with high
+// probability the giant component, if there is one
+template <typename VertexId>
+VertexId afforest_sample_frequent(std::size_t num_nodes, const VertexId *comp,
+                                  std::size_t num_samples = 1024) {
+    std::unordered_map<VertexId, std::size_t> count;
+    SplitMix64 rng(27491095);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        count[comp[rng.next_below(num_nodes)]]++;
+    }
+    return std::max_element(count.begin(), count.end(),
+                            [](const auto &a, const auto &b) {
+                                return a.second < b.second;
+                            })
+        ->first;
+}
+
+// Parallel connected components. Each vertex first links along its first
+// `neighbor_rounds` edges only, which already merges most of a giant
+// component; after compressing, a sample finds that component and the final
+// pass skips all of its vertices, so most edges are never touched. Linking is
+// the lock-free union-find of union_find.hpp.
+//
+// Labels match shiloach_vishkin(): the smallest vertex id of the component.
+// The graph should be undirected; for a directed graph pass its transpose to
+// get weakly connected components (vertices outside the giant component then
+// also link along their in-edges).
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto afforest(const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+              const CSRGraph<VertexId, EdgeOffset, Weight> *transpose = nullptr,
+              int neighbor_rounds = 2) {
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const std::size_t num_nodes = graph.num_nodes();
+    std::vector<VertexId> label(num_nodes);
+    auto *comp = label.data();
+    if (num_nodes == 0) {
+        return label;
+    }
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        comp[v] = static_cast<VertexId>(v);
+    }
+
+    //>> Neighbor sampling: round r links every vertex to its r-th neighbor
+    for (int r = 0; r < neighbor_rounds; r++) {
+#pragma omp parallel for schedule(dynamic, 16384)
+        for (std::size_t u = 0; u < num_nodes; u++) {
+            if (row_pointer[u] + r < row_pointer[u + 1]) {
+                union_find_link(static_cast<VertexId>(u),
+                                column_index[row_pointer[u] + r], comp);
+            }
+        }
+        union_find_compress(num_nodes, comp);
+    }
+
+    //>> Finish every vertex outside the giant component
+    const VertexId giant = afforest_sample_frequent(num_nodes, comp);
+#pragma omp parallel for schedule(dynamic, 16384)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        if (atomic_load(comp[u]) == giant) {
+            continue;
+        }
+        for (auto i = row_pointer[u] + neighbor_rounds; i < row_pointer[u + 1];
+             i++) {
+            union_find_link(static_cast<VertexId>(u), column_index[i], comp);
+        }
+        if (transpose != nullptr) {
+            // the first rounds only covered out-edges
+            for (auto i = transpose->row_ptr()[u];
+                 i < transpose->row_ptr()[u + 1]; i++) {
+                union_find_link(static_cast<VertexId>(u),
+                                transpose->col_idx()[i], comp);
+            }
+        }
+    }
+    union_find_compress(num_nodes, comp);
+    return label;
+}
+
+/********************
+ * Parallel Shiloach-Vishkin CC
+ ********************/
+struct SVIteration {
+    std::size_t active_vertices;  // vertices whose edges were scanned
+    std::size_t edges_scanned;
+    std::size_t hooks;            // successful min-writes on a root
+    std::size_t changed;          // vertices whose label changed
+};
+
+template <typename VertexId>
+struct SVResult {
+    std::vector<VertexId> label;  // smallest vertex id of the component
+    std::vector<SVIteration> iterations;
+};
+
+// Each iteration hooks with an atomic write_min: for an edge whose endpoint
+// labels differ, the larger label (always a root, since the previous
+// iteration compressed every tree to a star) is pointed at the smaller one.
+// Then every vertex jumps to its root in parallel.
+//
+// Only the vertices whose label changed in the last iteration scan their
+// edges in the next one: an edge between two unchanged vertices was already
+// equal, or was hooked and so changed one of its ends. On high-diameter graphs
+// the frontier shrinks as components settle and late iterations touch few
+// edges. The graph must be undirected (every edge stored in both lists).
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto parallel_shiloach_vishkin(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const std::size_t num_nodes = graph.num_nodes();
+    SVResult<VertexId> result;
+    result.label.resize(num_nodes);
+    auto *comp = result.label.data();
+    Bitmap active(num_nodes);
+    Bitmap hooked(num_nodes);  // roots written to in this iteration
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        comp[v] = static_cast<VertexId>(v);
+    }
+    std::size_t num_active = num_nodes;
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        active.set_bit(v);
+    }
+
+    while (num_active > 0) {
+        SVIteration stats{num_active, 0, 0, 0};
+        //? Hooking Phase
+        std::size_t edges_scanned = 0, hooks = 0;
+#pragma omp parallel for reduction(+ : edges_scanned, hooks) \
+    schedule(dynamic, 1024)
+        for (std::size_t u = 0; u < num_nodes; u++) {
+            if (!active.get_bit(u)) {
+                continue;
+            }
+            edges_scanned += row_pointer[u + 1] - row_pointer[u];
+            for (auto i = row_pointer[u]; i < row_pointer[u + 1]; i++) {
+                const VertexId cu = atomic_load(comp[u]);
+                const VertexId cv = atomic_load(comp[column_index[i]]);
+                if (cu == cv) {
+                    continue;
+                }
+                const VertexId high = std::max(cu, cv);
+                if (write_min(comp[high], std::min(cu, cv))) {
+                    hooked.set_bit_atomic(high);
+                    hooks++;
+                }
+            }
+        }
+        stats.edges_scanned = edges_scanned;
+        stats.hooks = hooks;
+
+        //? Shortcutting Phase
+        // a vertex changed iff the root it pointed to was hooked; hooking only
+        // writes roots, so comp[v] still holds that root unless v is one
+        active.reset();
+        std::size_t changed = 0;
+#pragma omp parallel for reduction(+ : changed) schedule(dynamic, 16384)
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            const std::size_t root = hooked.get_bit(v) ? v : comp[v];
+            if (hooked.get_bit(root)) {
+                active.set_bit_atomic(v);
+                changed++;
+            }
+            while (comp[v] != comp[comp[v]]) {
+                comp[v] = comp[comp[v]];
+            }
+        }
+        hooked.reset();
+        stats.changed = changed;
+        num_active = changed;
+        result.iterations.push_back(stats);
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
     // A cycle of 3 nodes: 0 -> 1 -> 2 -> 0
     // A cycle of 3 nodes: 3 -> 4 -> 5 -> 3
     std::vector<int> row_pointer = {0, 1, 2, 3, 4, 5, 6};
     std::vector<int> column_index = {1, 2, 0, 4, 5, 3};
+    CSRGraph<> graph(row_pointer, column_index);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
     //////////
     // dfs //
     /////////
 
-    auto label = dfs_cc(row_pointer, column_index);
+    auto label = dfs_cc(graph);
     std::cout << "Labels of dfs_cc: ";
     for (auto &l : label) {
         std::cout << l << ' ';
     }
 
-    label = union_find(row_pointer, column_index);
+    label = union_find(graph);
     std::cout << "\n\nLabels of Union Find: ";
     for (auto &l : label) {
         std::cout << l << ' ';
     }
 
-    label = shiloach_vishkin(row_pointer, column_index);
+    label = shiloach_vishkin(graph);
     std::cout << "\n\nLabels of Shiloach Vishkin: ";
     for (auto &l : label) {
         std::cout << l << ' ';
     }
+
+    label = afforest(graph);
+    std::cout << "\n\nLabels of Afforest: ";
+    for (auto &l : label) {
+        std::cout << l << ' ';
+    }
+
+    auto sv = parallel_shiloach_vishkin(graph);
+    std::cout << "\n\nLabels of parallel Shiloach Vishkin: ";
+    for (auto &l : sv.label) {
+        std::cout << l << ' ';
+    }
+    std::cout << "\niteration  active  edges  hooks  changed\n";
+    for (std::size_t i = 0; i < sv.iterations.size(); i++) {
+        const auto &it = sv.iterations[i];
+        std::cout << i << "  " << it.active_vertices << "  "
+                  << it.edges_scanned << "  " << it.hooks << "  "
+                  << it.changed << '\n';
+    }
     return 0;
 }
\ No newline at end of file
@@ -1,24 +1,36 @@
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
-std::vector<int> greedy_coloring(const std::vector<int> &row_ptr,
-                                 const std::vector<int> &col_idx) {
-    int num_nodes = row_ptr.size() - 1;
+#include "bitmap.hpp"
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "degeneracy.hpp"
+#include "parallel.hpp"
+#include "rng.hpp"
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<int> greedy_coloring(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
     std::vector<int> colors(num_nodes,
                             -1);  // one element is modified by every node
     std::vector<bool> used(num_nodes, false);  // reset by every node
     colors[0] = 0;
 
-    for (int i = 1; i < num_nodes; i++) {
-        for (int j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
+    for (std::size_t i = 1; i < num_nodes; i++) {
+        for (auto j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
             auto neighbor = col_idx[j];
             // mark the neighbor's color as used
             if (colors[neighbor] != -1) {
                 used[colors[neighbor]] = true;
             }
         }
-        int color = 0;
+        std::size_t color = 0;
         // find the first unused color
         for (; color < num_nodes; color++) {
             if (!used[color]) {
@@ -27,7 +39,7 @@ std::vector<int> greedy_coloring(const std::vector<int> &row_ptr,
         }
         colors[i] = color;
 
-        for (int j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
+        for (auto j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
             auto neighbor = col_idx[j];
             // reset the used array
             if (colors[neighbor] != -1) {
@@ -38,7 +50,206 @@ std::vector<int> greedy_coloring(const std::vector<int> &row_ptr,
     return colors;
 }
 
-int main() {
+/*
+ * Parallel coloring
+ *
+ * Both variants color vertices by first fit in a priority order, with a
+ * per-thread forbidden-color bitset of max_degree + 1 bits (first fit never
+ * needs more than degree(v) + 1 colors):
+ *  - Speculative (Gebremedhin-Manne): color the whole worklist in parallel
+ *    from possibly stale neighbor colors, then keep only the vertices that
+ *    clash with a higher-priority neighbor for the next round. Fast, but the
+ *    result depends on the thread timing.
+ *  - JonesPlassmann: a vertex is colored once all its higher-priority
+ *    neighbors are, so every round colors an independent set and the result
+ *    is exactly the serial greedy coloring in priority order, for any
+ *    number of threads. The number of rounds is the longest chain of
+ *    decreasing priorities, short for random priorities, but long for
+ *    smallest-last on graphs with a deep core hierarchy.
+ *
+ * Orders, priorities with ties broken by id:
+ *  - Random
+ *  - LargestFirst: higher degree first, fewer colors than random. For
+ *    Jones-Plassmann equal degrees are ordered randomly, an id order would
+ *    chain them up; speculative coloring keeps the id order, which visits
+ *    the graph with better locality.
+ *  - SmallestLast: reverse k-core peeling order, at most degeneracy + 1
+ *    colors
+ */
+enum class ColoringMode { Speculative, JonesPlassmann };
+
+enum class ColoringOrder { Random, LargestFirst, SmallestLast };
+
+struct ColoringOptions {
+    ColoringMode mode = ColoringMode::Speculative;
+    ColoringOrder order = ColoringOrder::LargestFirst;
+    uint64_t seed = 0;
+};
+
+// Larger value = colored earlier
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<uint64_t> coloring_priority(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph, ColoringOrder order,
+    uint64_t seed, bool random_ties) {
+    const auto num_nodes = graph.num_nodes();
+    std::vector<uint64_t> priority(num_nodes);
+    std::vector<VertexId> rank;
+    if (order == ColoringOrder::SmallestLast) {
+        rank = degeneracy_rank(graph);
+    }
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        const uint64_t noise = SplitMix64(seed, v)();
+        switch (order) {
+            case ColoringOrder::Random:
+                priority[v] = noise;
+                break;
+            case ColoringOrder::LargestFirst:
+                priority[v] = (uint64_t(graph.degree(v)) << 32) |
+                              (random_ties ? noise >> 32 : 0);
+                break;
+            case ColoringOrder::SmallestLast:
+                priority[v] = rank[v];  // peeled last, colored first
+                break;
+        }
+    }
+    return priority;
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<int> parallel_coloring(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    ColoringOptions options = {}) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const auto priority =
+        coloring_priority(graph, options.order, options.seed,
+                          options.mode == ColoringMode::JonesPlassmann);
+    auto before = [&](VertexId u, VertexId v) {
+        return priority[u] > priority[v] || (priority[u] == priority[v] && u < v);
+    };
+    EdgeOffset max_degree = 0;
+#pragma omp parallel for reduction(max : max_degree)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        max_degree = std::max(max_degree, graph.degree(v));
+    }
+
+    std::vector<int> colors(num_nodes, -1);
+    // smallest color not taken by a neighbor, forbidden is all zero before
+    // and after
+    auto first_fit = [&](VertexId v, Bitmap &forbidden) {
+        const auto degree = graph.degree(v);
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            const int color = atomic_load(colors[col_idx[i]]);
+            if (color >= 0 && color <= degree) {
+                forbidden.set_bit(color);
+            }
+        }
+        int color = 0;
+        while (forbidden.get_bit(color)) {
+            color++;
+        }
+        for (EdgeOffset c = 0; c <= degree; c++) {
+            forbidden.clear_bit(c);
+        }
+        return color;
+    };
+
+    if (options.mode == ColoringMode::Speculative) {
+        std::vector<VertexId> worklist(num_nodes);
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            worklist[v] = v;
+        }
+        std::sort(worklist.begin(), worklist.end(), before);
+        std::vector<char> conflict;
+        while (!worklist.empty()) {
+            // 1. Color, reading whatever the neighbors have right now
+#pragma omp parallel
+            {
+                Bitmap forbidden(max_degree + 1);
+#pragma omp for schedule(dynamic, 256)
+                for (std::size_t k = 0; k < worklist.size(); k++) {
+                    const auto v = worklist[k];
+                    atomic_store(colors[v], first_fit(v, forbidden));
+                }
+            }
+            // 2. Of two clashing neighbors, the later one tries again
+            conflict.assign(worklist.size(), 0);
+#pragma omp parallel for schedule(dynamic, 256)
+            for (std::size_t k = 0; k < worklist.size(); k++) {
+                const auto v = worklist[k];
+                for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                    const auto u = col_idx[i];
+                    if (u != v && colors[u] == colors[v] && before(u, v)) {
+                        conflict[k] = 1;
+                        break;
+                    }
+                }
+            }
+            std::size_t kept = 0;
+            for (std::size_t k = 0; k < worklist.size(); k++) {
+                if (conflict[k]) {
+                    worklist[kept++] = worklist[k];
+                }
+            }
+            worklist.resize(kept);
+        }
+        return colors;
+    }
+
+    // Jones-Plassmann: waiting[v] = uncolored neighbors that come first
+    std::vector<EdgeOffset> waiting(num_nodes, 0);
+    std::vector<VertexId> frontier;
+#pragma omp parallel
+    {
+        std::vector<VertexId> local_frontier;
+#pragma omp for schedule(dynamic, 1024) nowait
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                waiting[v] += before(col_idx[i], v);
+            }
+            if (waiting[v] == 0) {
+                local_frontier.push_back(v);
+            }
+        }
+#pragma omp critical
+        frontier.insert(frontier.end(), local_frontier.begin(),
+                        local_frontier.end());
+    }
+    while (!frontier.empty()) {
+        std::vector<VertexId> next_frontier;
+#pragma omp parallel
+        {
+            Bitmap forbidden(max_degree + 1);
+            std::vector<VertexId> local_frontier;
+            // the frontier is an independent set
+#pragma omp for schedule(dynamic, 256)
+            for (std::size_t k = 0; k < frontier.size(); k++) {
+                const auto v = frontier[k];
+                atomic_store(colors[v], first_fit(v, forbidden));
+            }
+#pragma omp for schedule(dynamic, 256) nowait
+            for (std::size_t k = 0; k < frontier.size(); k++) {
+                const auto v = frontier[k];
+                for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                    const auto u = col_idx[i];
+                    if (before(v, u) &&
+                        fetch_and_add(waiting[u], EdgeOffset(-1)) == 1) {
+                        local_frontier.push_back(u);
+                    }
+                }
+            }
+#pragma omp critical
+            next_frontier.insert(next_frontier.end(), local_frontier.begin(),
+                                 local_frontier.end());
+        }
+        frontier.swap(next_frontier);
+    }
+    return colors;
+}
+
+int main(int argc, char **argv) {
     /* Graph:
     0 -- 1
     |    |
@@ -49,12 +260,36 @@ int main() {
     std::vector<int> rowPtr = {0, 2, 4, 6, 8, 10};
     std::vector<int> colIndex = {1, 3, 0, 2, 1, 4, 0, 4, 2, 3};
 
-    std::vector<int> colors = greedy_coloring(rowPtr, colIndex);
+    CSRGraph<> graph(rowPtr, colIndex);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
+
+    std::vector<int> colors = greedy_coloring(graph);
 
     // Print the result
-    for (int i = 0; i < colors.size(); ++i) {
+    for (size_t i = 0; i < colors.size(); ++i) {
         std::cout << "Vertex " << i << " ---> Color " << colors[i] << std::endl;
     }
 
+    for (const auto mode :
+         {ColoringMode::Speculative, ColoringMode::JonesPlassmann}) {
+        for (const auto order :
+             {ColoringOrder::Random, ColoringOrder::LargestFirst,
+              ColoringOrder::SmallestLast}) {
+            colors = parallel_coloring(graph, {mode, order});
+            std::cout << (mode == ColoringMode::Speculative ? "speculative"
+                                                            : "Jones-Plassmann")
+                      << ", "
+                      << (order == ColoringOrder::Random         ? "random"
+                          : order == ColoringOrder::LargestFirst ? "largest-first"
+                                                                 : "smallest-last")
+                      << ": "
+                      << *std::max_element(colors.begin(), colors.end()) + 1
+                      << " colors" << std::endl;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "csr_io.hpp"
+#include "graph_reader.hpp"
+
+/*
+Converts a SNAP edge list or a Matrix Market file into the binary CSR format
+of csr_io.hpp, which the other programs load with load_csr().
+
+    convert [options] <input.txt|input.mtx> <output.csr>
+
+    -s  symmetrize (add the reverse of every edge)
+    -l  remove self loops
+    -d  remove duplicate edges (implies -o)
+    -o  sort every adjacency list
+    -w  keep edge weights (float, 1.0 where the input has none)
+    -L  large graph: uint32_t vertex ids and uint64_t edge offsets
+        (the default is int ids and int offsets, as the demos expect)
+ */
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void convert(const std::string &input, const std::string &output,
+             BuildOptions options) {
+    auto graph = read_graph<VertexId, EdgeOffset, Weight>(input, options);
+    write_csr(output, graph);
+    std::cout << input << " -> " << output << ": " << graph.num_nodes()
+              << " nodes, " << graph.num_edges() << " edges\n";
+}
+
+int main(int argc, char **argv) {
+    BuildOptions options;
+    bool weighted = false;
+    bool large = false;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        for (const char *flag = argv[arg] + 1; *flag; flag++) {
+            switch (*flag) {
+                case 's': options.symmetrize = true; break;
+                case 'l': options.remove_self_loops = true; break;
+                case 'd': options.remove_duplicates = true; break;
+                case 'o': options.sort_neighbors = true; break;
+                case 'w': weighted = true; break;
+                case 'L': large = true; break;
+                default:
+                    std::cerr << "unknown option -" << *flag << '\n';
+                    return 1;
+            }
+        }
+    }
+    if (argc - arg != 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " [-sldowL] <input.txt|input.mtx> <output.csr>\n";
+        return 1;
+    }
+    const std::string input = argv[arg];
+    const std::string output = argv[arg + 1];
+
+    try {
+        if (large) {
+            weighted ? convert<uint32_t, uint64_t, float>(input, output, options)
+                     : convert<uint32_t, uint64_t, Unweighted>(input, output,
+                                                               options);
+        } else {
+            weighted ? convert<int, int, float>(input, output, options)
+                     : convert<int, int, Unweighted>(input, output, options);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+CSRGraph is the graph type shared by every kernel in this repo.
+
+It is a read-only view over the three Compressed Sparse Row arrays:
+    row_ptr : num_nodes + 1 offsets into col_idx           (EdgeOffset)
+    col_idx : num_edges neighbor ids                        (VertexId)
+    values  : num_edges edge weights, aligned with col_idx  (Weight)
+
+The id widths are template parameters so that a graph with 5B edges can use
+uint64_t offsets while keeping 4-byte uint32_t neighbor ids. Unweighted graphs
+use the `Unweighted` tag as Weight and carry no values array at all.
+
+The arrays are either owned by the graph (built from std::vector) or borrowed
+from somewhere else, e.g. a memory-mapped file; in the latter case `owner`
+keeps the memory alive for as long as any copy of the graph exists. Copying a
+CSRGraph is therefore cheap and never duplicates the arrays.
+
+Copies also share a cache slot for the transpose, so kernels that need the
+in-edges (bottom-up BFS, backward SCC passes) build it at most once per graph;
+see transpose_of() in transpose.hpp.
+ */
+
+// Weight tag for graphs without edge values
+struct Unweighted {};
+
+// A [first, last) range over contiguous memory, e.g. the neighbors of a vertex
+template <typename T>
+class ArrayView {
+   public:
+    ArrayView() = default;
+    ArrayView(const T *first, const T *last) : first_(first), last_(last) {}
+
+    const T *begin() const { return first_; }
+    const T *end() const { return last_; }
+    std::size_t size() const { return last_ - first_; }
+    bool empty() const { return first_ == last_; }
+    const T &operator[](std::size_t i) const { return first_[i]; }
+
+   private:
+    const T *first_ = nullptr;
+    const T *last_ = nullptr;
+};
+
+template <typename VertexId = int, typename EdgeOffset = int,
+          typename Weight = Unweighted>
+class CSRGraph {
+    static_assert(std::is_integral_v<VertexId>, "VertexId must be integral");
+    static_assert(std::is_integral_v<EdgeOffset>,
+                  "EdgeOffset must be integral");
+
+   public:
+    using vertex_type = VertexId;
+    using offset_type = EdgeOffset;
+    using weight_type = Weight;
+
+    static constexpr bool is_weighted = !std::is_same_v<Weight, Unweighted>;
+    // -1 for signed ids, the maximum value for unsigned ones
+    static constexpr VertexId invalid_vertex = static_cast<VertexId>(-1);
+
+    CSRGraph() = default;
+
+    // Owning graph, takes over the arrays
+    CSRGraph(std::vector<EdgeOffset> row_ptr, std::vector<VertexId> col_idx,
+             std::vector<Weight> values = {}) {
+        auto storage = std::make_shared<Storage>();
+        storage->row_ptr = std::move(row_ptr);
+        storage->col_idx = std::move(col_idx);
+        storage->values = std::move(values);
+
+        row_ptr_ = storage->row_ptr.data();
+        col_idx_ = storage->col_idx.data();
+        values_ = is_weighted ? storage->values.data() : nullptr;
+        num_nodes_ = storage->row_ptr.empty() ? 0 : storage->row_ptr.size() - 1;
+        num_edges_ = storage->col_idx.size();
+        owner_ = std::move(storage);
+    }
+
+    // Borrowed graph, `owner` (may be null) keeps the arrays alive
+    CSRGraph(const EdgeOffset *row_ptr, const VertexId *col_idx,
+             const Weight *values, std::size_t num_nodes,
+             std::size_t num_edges, std::shared_ptr<const void> owner = nullptr)
+        : row_ptr_(row_ptr),
+          col_idx_(col_idx),
+          values_(values),
+          num_nodes_(num_nodes),
+          num_edges_(num_edges),
+          owner_(std::move(owner)) {}
+
+    std::size_t num_nodes() const { return num_nodes_; }
+    std::size_t num_edges() const { return num_edges_; }
+
+    const EdgeOffset *row_ptr() const { return row_ptr_; }
+    const VertexId *col_idx() const { return col_idx_; }
+    const Weight *values() const { return values_; }
+
+    EdgeOffset degree(VertexId v) const { return row_ptr_[v + 1] - row_ptr_[v]; }
+
+    ArrayView<VertexId> neighbors(VertexId v) const {
+        return {col_idx_ + row_ptr_[v], col_idx_ + row_ptr_[v + 1]};
+    }
+
+    ArrayView<Weight> weights(VertexId v) const {
+        static_assert(is_weighted, "weights() on an unweighted graph");
+        return {values_ + row_ptr_[v], values_ + row_ptr_[v + 1]};
+    }
+
+    // Returns the cached transpose, calling make() to build it on first use.
+    // Thread-safe; the cache is shared by all copies of this graph.
+    template <typename Make>
+    const CSRGraph &cached_transpose(Make make) const {
+        std::call_once(cache_->once, [&] {
+            cache_->transpose = std::make_shared<const CSRGraph>(make());
+        });
+        return *cache_->transpose;
+    }
+
+   private:
+    struct TransposeCache {
+        std::once_flag once;
+        std::shared_ptr<const CSRGraph> transpose;
+    };
+
+    struct Storage {
+        std::vector<EdgeOffset> row_ptr;
+        std::vector<VertexId> col_idx;
+        std::vector<Weight> values;
+    };
+
+    const EdgeOffset *row_ptr_ = nullptr;
+    const VertexId *col_idx_ = nullptr;
+    const Weight *values_ = nullptr;
+    std::size_t num_nodes_ = 0;
+    std::size_t num_edges_ = 0;
+    std::shared_ptr<const void> owner_;
+    std::shared_ptr<TransposeCache> cache_ = std::make_shared<TransposeCache>();
+};
+
+// The common id policies
+template <typename Weight = Unweighted>
+using CSRGraph32 = CSRGraph<uint32_t, uint32_t, Weight>;  // < 2^32 edges
+template <typename Weight = Unweighted>
+using CSRGraph32x64 = CSRGraph<uint32_t, uint64_t, Weight>;  // < 2^32 nodes
+template <typename Weight = Unweighted>
+using CSRGraph64 = CSRGraph<uint64_t, uint64_t, Weight>;
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "csr_graph.hpp"
+
+/*
+Binary CSR file format, little-endian, every section 64-byte aligned:
+
+    CSRFileHeader                          64 bytes
+    row_ptr  [num_nodes + 1] EdgeOffset
+    col_idx  [num_edges]     VertexId
+    values   [num_edges]     Weight        only if weight_bytes != 0
+
+The arrays are stored exactly as CSRGraph keeps them in memory, so
+load_csr() maps the file and hands out pointers into the mapping without
+parsing or copying anything. The mapping is MAP_SHARED and read-only, so every
+process loading the same file shares one copy in the page cache.
+ */
+
+enum class CSRTypeKind : uint8_t { None = 0, Unsigned = 1, Signed = 2, Float = 3 };
+
+struct CSRFileHeader {
+    char magic[8];  // "CSRGRAPH"
+    uint32_t version;
+    uint8_t vertex_bytes;
+    uint8_t offset_bytes;
+    uint8_t weight_bytes;  // 0 for unweighted graphs
+    CSRTypeKind weight_kind;
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t row_ptr_offset;  // byte offsets of the arrays in the file
+    uint64_t col_idx_offset;
+    uint64_t values_offset;
+    uint8_t reserved[8];
+};
+static_assert(sizeof(CSRFileHeader) == 64, "CSRFileHeader must be 64 bytes");
+
+inline constexpr char csr_file_magic[8] = {'C', 'S', 'R', 'G',
+                                           'R', 'A', 'P', 'H'};
+inline constexpr uint32_t csr_file_version = 1;
+
+namespace csr_io_detail {
+
+inline uint64_t align_up(uint64_t bytes) { return (bytes + 63) & ~uint64_t(63); }
+
+// End of the section of count items of item_bytes each at offset; false if
+// the offset is not 64-byte aligned, the section starts before begin, or
+// the arithmetic overflows
+inline bool section_end(uint64_t offset, uint64_t count, uint64_t item_bytes,
+                        uint64_t begin, uint64_t &end) {
+    constexpr uint64_t max = ~uint64_t(0);
+    if (offset % 64 != 0 || offset < begin ||
+        (item_bytes != 0 && count > max / item_bytes) ||
+        count * item_bytes > max - offset) {
+        return false;
+    }
+    end = offset + count * item_bytes;
+    return true;
+}
+
+template <typename T>
+constexpr CSRTypeKind kind_of() {
+    if constexpr (std::is_same_v<T, Unweighted>) {
+        return CSRTypeKind::None;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return CSRTypeKind::Float;
+    } else if constexpr (std::is_signed_v<T>) {
+        return CSRTypeKind::Signed;
+    } else {
+        return CSRTypeKind::Unsigned;
+    }
+}
+
+template <typename T>
+constexpr uint8_t bytes_of() {
+    return std::is_same_v<T, Unweighted> ? 0 : sizeof(T);
+}
+
+// An mmap'ed file, unmapped when the last graph referring to it goes away
+class MappedFile {
+   public:
+    MappedFile(void *data, std::size_t size) : data_(data), size_(size) {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { munmap(data_, size_); }
+
+    const char *data() const { return static_cast<const char *>(data_); }
+    std::size_t size() const { return size_; }
+
+   private:
+    void *data_;
+    std::size_t size_;
+};
+
+}  // namespace csr_io_detail
+
+struct MapOptions {
+    bool populate = false;    // MAP_POPULATE: fault in the whole file up front
+    bool huge_pages = false;  // madvise(MADV_HUGEPAGE) on the mapping
+};
+
+// Reads and validates only the header
+inline CSRFileHeader read_csr_header(const std::string &path) {
+    CSRFileHeader header{};
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        throw std::runtime_error("cannot read CSR header from " + path);
+    }
+    if (std::memcmp(header.magic, csr_file_magic, sizeof(csr_file_magic)) !=
+        0) {
+        throw std::runtime_error(path + " is not a binary CSR file");
+    }
+    if (header.version != csr_file_version) {
+        throw std::runtime_error(path + ": unsupported CSR file version " +
+                                 std::to_string(header.version));
+    }
+    return header;
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void write_csr(const std::string &path,
+               const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    using namespace csr_io_detail;
+    const uint64_t num_nodes = graph.num_nodes();
+    const uint64_t num_edges = graph.num_edges();
+
+    CSRFileHeader header{};
+    std::memcpy(header.magic, csr_file_magic, sizeof(csr_file_magic));
+    header.version = csr_file_version;
+    header.vertex_bytes = sizeof(VertexId);
+    header.offset_bytes = sizeof(EdgeOffset);
+    header.weight_bytes = bytes_of<Weight>();
+    header.weight_kind = kind_of<Weight>();
+    header.num_nodes = num_nodes;
+    header.num_edges = num_edges;
+    header.row_ptr_offset = sizeof(CSRFileHeader);
+    header.col_idx_offset = align_up(
+        header.row_ptr_offset + (num_nodes + 1) * sizeof(EdgeOffset));
+    header.values_offset =
+        align_up(header.col_idx_offset + num_edges * sizeof(VertexId));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("cannot open " + path + " for writing");
+    }
+    // pad the stream up to the next section
+    auto write_section = [&out](uint64_t offset, const void *data,
+                                uint64_t bytes) {
+        static const char zeros[64] = {};
+        out.write(zeros, offset - static_cast<uint64_t>(out.tellp()));
+        out.write(static_cast<const char *>(data), bytes);
+    };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write_section(header.row_ptr_offset, graph.row_ptr(),
+                  (num_nodes + 1) * sizeof(EdgeOffset));
+    write_section(header.col_idx_offset, graph.col_idx(),
+                  num_edges * sizeof(VertexId));
+    if constexpr (CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted) {
+        write_section(header.values_offset, graph.values(),
+                      num_edges * sizeof(Weight));
+    }
+    if (!out) {
+        throw std::runtime_error("failed writing " + path);
+    }
+}
+
+// Maps a file written by write_csr() and returns a graph pointing into it.
+// The id widths of the file must match VertexId/EdgeOffset (signedness is not
+// checked), and the weight type must match Weight exactly. The header's
+// section offsets and sizes are checked against the file, and row_ptr
+// against 0 and num_edges at its ends; the array contents are not scanned.
+template <typename VertexId, typename EdgeOffset, typename Weight = Unweighted>
+CSRGraph<VertexId, EdgeOffset, Weight> load_csr(const std::string &path,
+                                                MapOptions options = {}) {
+    using namespace csr_io_detail;
+    const auto header = read_csr_header(path);
+    if (header.vertex_bytes != sizeof(VertexId) ||
+        header.offset_bytes != sizeof(EdgeOffset)) {
+        throw std::runtime_error(
+            path + ": stored with " + std::to_string(header.vertex_bytes) +
+            "-byte vertex ids and " + std::to_string(header.offset_bytes) +
+            "-byte offsets");
+    }
+    if (header.weight_bytes != bytes_of<Weight>() ||
+        header.weight_kind != kind_of<Weight>()) {
+        throw std::runtime_error(path + ": edge weight type mismatch");
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    const std::size_t size = st.st_size;
+    // the sections must follow each other in order, aligned, within the file
+    uint64_t row_ptr_end = 0, col_idx_end = 0, values_end = 0;
+    bool valid =
+        header.num_nodes < ~uint64_t(0) &&
+        section_end(header.row_ptr_offset, header.num_nodes + 1,
+                    sizeof(EdgeOffset), sizeof(CSRFileHeader), row_ptr_end) &&
+        section_end(header.col_idx_offset, header.num_edges, sizeof(VertexId),
+                    row_ptr_end, col_idx_end);
+    if (valid && bytes_of<Weight>() != 0) {
+        valid = section_end(header.values_offset, header.num_edges,
+                            bytes_of<Weight>(), col_idx_end, values_end);
+    }
+    const uint64_t end = bytes_of<Weight>() == 0 ? col_idx_end : values_end;
+    if (!valid) {
+        close(fd);
+        throw std::runtime_error(path + ": corrupt CSR header");
+    }
+    if (size < end) {
+        close(fd);
+        throw std::runtime_error(path + " is truncated");
+    }
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void *data = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    close(fd);  // the mapping keeps its own reference to the file
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("cannot mmap " + path);
+    }
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages) {
+        madvise(data, size, MADV_HUGEPAGE);  // only a hint, ignore failure
+    }
+#endif
+
+    auto file = std::make_shared<const MappedFile>(data, size);
+    const char *base = file->data();
+    const auto *row_ptr =
+        reinterpret_cast<const EdgeOffset *>(base + header.row_ptr_offset);
+    if (row_ptr[0] != 0 ||
+        static_cast<uint64_t>(row_ptr[header.num_nodes]) != header.num_edges) {
+        throw std::runtime_error(path + ": row_ptr does not span num_edges");
+    }
+    const Weight *values = nullptr;
+    if constexpr (CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted) {
+        values = reinterpret_cast<const Weight *>(base + header.values_offset);
+    }
+    return CSRGraph<VertexId, EdgeOffset, Weight>(
+        row_ptr,
+        reinterpret_cast<const VertexId *>(base + header.col_idx_offset),
+        values, header.num_nodes, header.num_edges, std::move(file));
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+
+/*
+Degeneracy (k-core peeling) order: repeatedly remove a vertex of minimum
+remaining degree. Orienting edges along it bounds every out-degree by the
+degeneracy (triangle counting), and coloring in reverse removal order is the
+smallest-last heuristic (coloring).
+ */
+
+// Position of every vertex in a k-core peeling order (Batagelj-Zaversnik
+// bucket sort, O(n + m), serial)
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<VertexId> degeneracy_rank(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    std::vector<EdgeOffset> degree(num_nodes);
+    EdgeOffset max_degree = 0;
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        degree[v] = graph.degree(v);
+        max_degree = std::max(max_degree, degree[v]);
+    }
+    // vertices sorted by current degree, bucket_start[d] = first slot of
+    // degree d
+    std::vector<std::size_t> bucket_start(max_degree + 2, 0);
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        bucket_start[degree[v] + 1]++;
+    }
+    for (std::size_t d = 0; d <= static_cast<std::size_t>(max_degree); d++) {
+        bucket_start[d + 1] += bucket_start[d];
+    }
+    std::vector<VertexId> order(num_nodes);
+    std::vector<std::size_t> position(num_nodes);
+    {
+        std::vector<std::size_t> fill(bucket_start.begin(),
+                                      bucket_start.end() - 1);
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            position[v] = fill[degree[v]]++;
+            order[position[v]] = static_cast<VertexId>(v);
+        }
+    }
+    // peel in order; a neighbor with a higher degree moves one bucket down
+    for (std::size_t k = 0; k < num_nodes; k++) {
+        const auto v = order[k];
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            const auto u = col_idx[i];
+            if (degree[u] > degree[v]) {
+                // swap u with the first vertex of its bucket, then shrink the
+                // bucket
+                const auto d = degree[u];
+                const auto first = std::max(bucket_start[d], k + 1);
+                const auto w = order[first];
+                std::swap(order[position[u]], order[first]);
+                std::swap(position[u], position[w]);
+                bucket_start[d] = first + 1;
+                degree[u]--;
+            }
+        }
+    }
+    std::vector<VertexId> rank(num_nodes);
+#pragma omp parallel for
+    for (std::size_t k = 0; k < num_nodes; k++) {
+        rank[order[k]] = static_cast<VertexId>(k);
+    }
+    return rank;
+}
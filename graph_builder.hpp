@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+
+/*
+Builds a CSRGraph from an unordered list of edges.
+
+    1. count the out-degree of every vertex in parallel (atomic increments)
+    2. prefix-sum the degrees into row_ptr
+    3. scatter every edge to its slot, each vertex hands out slots through an
+       atomic cursor
+    4. optionally sort every adjacency list and drop duplicates, then compact
+       the lists with a second prefix sum
+ */
+
+// Edges stored as a structure of arrays, weights only for weighted graphs
+template <typename VertexId, typename Weight = Unweighted>
+struct EdgeList {
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    std::vector<Weight> weights;  // empty when Weight = Unweighted
+    std::size_t num_nodes = 0;
+    // only one direction of every edge is stored (e.g. a symmetric Matrix
+    // Market file), build_csr() adds the reverse edges
+    bool symmetric = false;
+
+    std::size_t size() const { return sources.size(); }
+};
+
+struct BuildOptions {
+    bool symmetrize = false;         // add v -> u for every u -> v
+    bool remove_self_loops = false;  // drop u -> u
+    bool remove_duplicates = false;  // keep one copy of u -> v, implies sorting
+    bool sort_neighbors = false;     // sort every adjacency list by target id
+};
+
+// Sorts every adjacency list in place, on the neighbor ids and then on the
+// weights, so that among parallel edges the lightest one comes first
+template <typename EdgeOffset, typename VertexId, typename Weight = Unweighted>
+void sort_adjacency(const std::vector<EdgeOffset> &row_ptr,
+                    std::vector<VertexId> &col_idx,
+                    std::vector<Weight> *values = nullptr) {
+    const auto num_nodes = row_ptr.size() - 1;
+#pragma omp parallel
+    {
+        std::vector<std::pair<VertexId, Weight>> scratch;
+#pragma omp for schedule(dynamic, 1024)
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            const auto begin = row_ptr[v];
+            const auto end = row_ptr[v + 1];
+            if constexpr (std::is_same_v<Weight, Unweighted>) {
+                std::sort(col_idx.begin() + begin, col_idx.begin() + end);
+            } else {
+                scratch.clear();
+                for (auto i = begin; i < end; i++) {
+                    scratch.emplace_back(col_idx[i], (*values)[i]);
+                }
+                std::sort(scratch.begin(), scratch.end());
+                for (auto i = begin; i < end; i++) {
+                    col_idx[i] = scratch[i - begin].first;
+                    (*values)[i] = scratch[i - begin].second;
+                }
+            }
+        }
+    }
+}
+
+template <typename EdgeOffset, typename VertexId, typename Weight>
+CSRGraph<VertexId, EdgeOffset, Weight> build_csr(
+    const EdgeList<VertexId, Weight> &edges, BuildOptions options = {}) {
+    constexpr bool is_weighted = !std::is_same_v<Weight, Unweighted>;
+    const std::size_t num_nodes = edges.num_nodes;
+    const std::size_t num_input = edges.size();
+    const bool symmetrize = options.symmetrize || edges.symmetric;
+    const bool remove_self_loops = options.remove_self_loops;
+    const auto *sources = edges.sources.data();
+    const auto *targets = edges.targets.data();
+
+    //>> Count degrees
+    std::vector<EdgeOffset> degree(num_nodes, 0);
+#pragma omp parallel for
+    for (std::size_t e = 0; e < num_input; e++) {
+        const auto u = sources[e];
+        const auto v = targets[e];
+        if (u == v && remove_self_loops) {
+            continue;
+        }
+        fetch_and_add(degree[u], EdgeOffset(1));
+        // a self loop is stored once even when symmetrizing
+        if (symmetrize && u != v) {
+            fetch_and_add(degree[v], EdgeOffset(1));
+        }
+    }
+    std::vector<EdgeOffset> row_ptr = prefix_sum<EdgeOffset>(degree);
+    const std::size_t num_edges = row_ptr[num_nodes];
+
+    //>> Scatter
+    std::vector<VertexId> col_idx(num_edges);
+    std::vector<Weight> values(is_weighted ? num_edges : 0);
+    std::vector<EdgeOffset> cursor(row_ptr.begin(), row_ptr.end() - 1);
+#pragma omp parallel for
+    for (std::size_t e = 0; e < num_input; e++) {
+        const auto u = sources[e];
+        const auto v = targets[e];
+        if (u == v && remove_self_loops) {
+            continue;
+        }
+        auto slot = fetch_and_add(cursor[u], EdgeOffset(1));
+        col_idx[slot] = v;
+        if constexpr (is_weighted) {
+            values[slot] = edges.weights[e];
+        }
+        if (symmetrize && u != v) {
+            slot = fetch_and_add(cursor[v], EdgeOffset(1));
+            col_idx[slot] = u;
+            if constexpr (is_weighted) {
+                values[slot] = edges.weights[e];
+            }
+        }
+    }
+    std::vector<EdgeOffset>().swap(cursor);
+
+    //>> Sort and deduplicate
+    if (options.sort_neighbors || options.remove_duplicates) {
+        sort_adjacency(row_ptr, col_idx, is_weighted ? &values : nullptr);
+    }
+    if (!options.remove_duplicates) {
+        return {std::move(row_ptr), std::move(col_idx), std::move(values)};
+    }
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        // unique in place, the first (lightest) copy survives
+        EdgeOffset kept = 0;
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            if (kept > 0 && col_idx[row_ptr[v] + kept - 1] == col_idx[i]) {
+                continue;
+            }
+            col_idx[row_ptr[v] + kept] = col_idx[i];
+            if constexpr (is_weighted) {
+                values[row_ptr[v] + kept] = values[i];
+            }
+            kept++;
+        }
+        degree[v] = kept;
+    }
+    std::vector<EdgeOffset> compact_ptr = prefix_sum<EdgeOffset>(degree);
+    std::vector<VertexId> compact_idx(compact_ptr[num_nodes]);
+    std::vector<Weight> compact_values(is_weighted ? compact_idx.size() : 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        std::copy_n(col_idx.begin() + row_ptr[v], degree[v],
+                    compact_idx.begin() + compact_ptr[v]);
+        if constexpr (is_weighted) {
+            std::copy_n(values.begin() + row_ptr[v], degree[v],
+                        compact_values.begin() + compact_ptr[v]);
+        }
+    }
+    return {std::move(compact_ptr), std::move(compact_idx),
+            std::move(compact_values)};
+}
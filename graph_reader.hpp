@@ -0,0 +1,314 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csr_io.hpp"
+#include "graph_builder.hpp"
+#include "parallel.hpp"
+
+/*
+Text graph readers, producing an EdgeList for build_csr().
+
+    SNAP / plain edge list : "u v [w]" per line, 0-based ids, lines starting
+                             with '#' or '%' are comments
+    Matrix Market (.mtx)   : "%%MatrixMarket matrix coordinate <field> <sym>"
+                             banner, a "rows cols nnz" size line, then
+                             "i j [w]" entries with 1-based ids
+
+The file is mapped into memory and cut into one chunk per thread at line
+boundaries; every thread parses its chunk with std::from_chars into its own
+arrays, which are then concatenated in parallel. There is no iostream in the
+hot loop, so parsing keeps up with the disk.
+ */
+
+namespace graph_reader_detail {
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Parses one line [first, last) into up to three fields, returns how many,
+// or -1 if the line does not end after them. Every field must be followed by
+// whitespace, a '#' / '%' comment or the end of the line. A weighted read
+// takes the third field as the weight; an unweighted one allows and ignores
+// a third numeric field.
+template <typename Weight>
+int parse_line(const char *first, const char *last, uint64_t &u, uint64_t &v,
+               Weight &w) {
+    auto skip = [&]() {
+        while (first < last && is_space(*first)) {
+            first++;
+        }
+    };
+    auto at_end = [&]() {
+        return first == last || *first == '#' || *first == '%';
+    };
+    // parses one field, which must end at a separator
+    auto field = [&](auto &value) {
+        skip();
+        auto [next, error] = std::from_chars(first, last, value);
+        if (error != std::errc() ||
+            (next < last && !is_space(*next) && *next != '#' && *next != '%')) {
+            return false;
+        }
+        first = next;
+        return true;
+    };
+    if (!field(u)) {
+        return 0;
+    }
+    if (!field(v)) {
+        return 1;
+    }
+    skip();
+    if (at_end()) {
+        return 2;
+    }
+    double value;
+    if (!field(value)) {
+        return -1;
+    }
+    skip();
+    if (!at_end()) {
+        return -1;
+    }
+    if constexpr (!std::is_same_v<Weight, Unweighted>) {
+        w = static_cast<Weight>(value);
+    }
+    return 3;
+}
+
+// Parses the lines of data[begin, end) in parallel. One-based ids are shifted
+// down by one, after which sources must be below num_rows and targets below
+// num_cols. Returns the largest id seen plus one.
+template <typename VertexId, typename Weight>
+std::size_t parse_edges(const char *data, std::size_t begin, std::size_t end,
+                        bool one_based, uint64_t num_rows, uint64_t num_cols,
+                        const std::string &path,
+                        EdgeList<VertexId, Weight> &edges) {
+    constexpr bool is_weighted = !std::is_same_v<Weight, Unweighted>;
+    const int num_chunks = num_threads();
+    // a line belongs to the chunk its first character falls into
+    auto line_start = [&](std::size_t pos) {
+        if (pos <= begin) {
+            return begin;
+        }
+        while (pos < end && data[pos - 1] != '\n') {
+            pos++;
+        }
+        return pos;
+    };
+    std::vector<EdgeList<VertexId, Weight>> local(num_chunks);
+    std::vector<std::size_t> max_id(num_chunks, 0);
+    constexpr uint64_t max_vertex =
+        static_cast<uint64_t>(std::numeric_limits<VertexId>::max());
+    bool malformed = false;
+    bool too_large = false;
+    bool out_of_bounds = false;
+
+#pragma omp parallel for schedule(static, 1) \
+    reduction(|| : malformed, too_large, out_of_bounds)
+    for (int c = 0; c < num_chunks; c++) {
+        const std::size_t span = end - begin;
+        std::size_t pos = line_start(begin + span * c / num_chunks);
+        const std::size_t stop = line_start(begin + span * (c + 1) / num_chunks);
+        auto &out = local[c];
+        while (pos < stop) {
+            const char *line = data + pos;
+            const char *line_end = static_cast<const char *>(
+                std::memchr(line, '\n', stop - pos));
+            if (line_end == nullptr) {
+                line_end = data + stop;
+            }
+            pos = line_end - data + 1;
+            while (line < line_end && is_space(*line)) {
+                line++;
+            }
+            if (line == line_end || *line == '#' || *line == '%') {
+                continue;  // blank or comment line
+            }
+            uint64_t u, v;
+            Weight w{};
+            const int fields = parse_line(line, line_end, u, v, w);
+            if (fields < 2 || (one_based && (u == 0 || v == 0))) {
+                malformed = true;
+                continue;
+            }
+            if (one_based) {
+                u--;
+                v--;
+            }
+            if (u > max_vertex || v > max_vertex) {
+                too_large = true;
+                continue;
+            }
+            if (u >= num_rows || v >= num_cols) {
+                out_of_bounds = true;
+                continue;
+            }
+            out.sources.push_back(static_cast<VertexId>(u));
+            out.targets.push_back(static_cast<VertexId>(v));
+            if constexpr (is_weighted) {
+                out.weights.push_back(fields == 3 ? w : Weight(1));
+            }
+            max_id[c] = std::max<std::size_t>(max_id[c], std::max(u, v) + 1);
+        }
+    }
+    if (malformed) {
+        throw std::runtime_error(path + ": malformed edge line");
+    }
+    if (too_large) {
+        throw std::runtime_error(path + ": vertex id too large for the id type");
+    }
+    if (out_of_bounds) {
+        throw std::runtime_error(path +
+                                 ": entry outside the declared dimensions");
+    }
+
+    std::vector<std::size_t> sizes(num_chunks);
+    for (int c = 0; c < num_chunks; c++) {
+        sizes[c] = local[c].size();
+    }
+    const auto offsets = prefix_sum<std::size_t>(sizes);
+    edges.sources.resize(offsets[num_chunks]);
+    edges.targets.resize(offsets[num_chunks]);
+    edges.weights.resize(is_weighted ? offsets[num_chunks] : 0);
+#pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < num_chunks; c++) {
+        auto &in = local[c];
+        std::copy(in.sources.begin(), in.sources.end(),
+                  edges.sources.begin() + offsets[c]);
+        std::copy(in.targets.begin(), in.targets.end(),
+                  edges.targets.begin() + offsets[c]);
+        std::copy(in.weights.begin(), in.weights.end(),
+                  edges.weights.begin() + offsets[c]);
+        std::vector<VertexId>().swap(in.sources);
+        std::vector<VertexId>().swap(in.targets);
+        std::vector<Weight>().swap(in.weights);
+    }
+    return *std::max_element(max_id.begin(), max_id.end());
+}
+
+inline std::shared_ptr<const csr_io_detail::MappedFile> map_text_file(
+    const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    const std::size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        throw std::runtime_error(path + " is empty");
+    }
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("cannot mmap " + path);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    return std::make_shared<const csr_io_detail::MappedFile>(data, size);
+}
+
+}  // namespace graph_reader_detail
+
+// SNAP-style edge list, the number of nodes is the largest id plus one
+template <typename VertexId, typename Weight = Unweighted>
+EdgeList<VertexId, Weight> read_edge_list(const std::string &path) {
+    using namespace graph_reader_detail;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("cannot stat " + path);
+    }
+    EdgeList<VertexId, Weight> edges;
+    if (st.st_size == 0) {
+        return edges;
+    }
+    auto file = map_text_file(path);
+    constexpr uint64_t no_limit = std::numeric_limits<uint64_t>::max();
+    edges.num_nodes = parse_edges(file->data(), 0, file->size(), false,
+                                  no_limit, no_limit, path, edges);
+    return edges;
+}
+
+template <typename VertexId, typename Weight = Unweighted>
+EdgeList<VertexId, Weight> read_matrix_market(const std::string &path) {
+    using namespace graph_reader_detail;
+    auto file = map_text_file(path);
+    const char *data = file->data();
+    const std::size_t size = file->size();
+
+    // banner
+    const char *eol = static_cast<const char *>(std::memchr(data, '\n', size));
+    std::string banner(data, eol ? eol : data + size);
+    std::transform(banner.begin(), banner.end(), banner.begin(), ::tolower);
+    if (banner.rfind("%%matrixmarket matrix coordinate", 0) != 0) {
+        throw std::runtime_error(path +
+                                 ": not a coordinate Matrix Market file");
+    }
+    if (banner.find("complex") != std::string::npos ||
+        banner.find("skew-symmetric") != std::string::npos ||
+        banner.find("hermitian") != std::string::npos) {
+        throw std::runtime_error(path + ": unsupported Matrix Market type");
+    }
+
+    // skip comments up to the size line
+    std::size_t pos = 0;
+    while (pos < size && (data[pos] == '%' || data[pos] == '\n')) {
+        const char *next =
+            static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+        pos = next ? next - data + 1 : size;
+    }
+    const char *line_end =
+        static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+    if (line_end == nullptr) {
+        throw std::runtime_error(path + ": missing Matrix Market size line");
+    }
+    uint64_t rows = 0, cols = 0;
+    Weight unused{};
+    if (parse_line(data + pos, line_end, rows, cols, unused) < 2) {
+        throw std::runtime_error(path + ": bad Matrix Market size line");
+    }
+    const uint64_t num_nodes = std::max(rows, cols);
+    if (num_nodes > 0 &&
+        num_nodes - 1 >
+            static_cast<uint64_t>(std::numeric_limits<VertexId>::max())) {
+        throw std::runtime_error(path +
+                                 ": dimensions too large for the id type");
+    }
+
+    EdgeList<VertexId, Weight> edges;
+    edges.symmetric = banner.find("symmetric") != std::string::npos;
+    parse_edges(data, line_end - data + 1, size, true, rows, cols, path, edges);
+    edges.num_nodes = num_nodes;
+    return edges;
+}
+
+// Picks the reader by file extension (.mtx is Matrix Market, anything else
+// an edge list) and builds the CSR graph
+template <typename VertexId, typename EdgeOffset, typename Weight = Unweighted>
+CSRGraph<VertexId, EdgeOffset, Weight> read_graph(const std::string &path,
+                                                  BuildOptions options = {}) {
+    const bool is_mtx =
+        path.size() >= 4 && path.compare(path.size() - 4, 4, ".mtx") == 0;
+    auto edges = is_mtx ? read_matrix_market<VertexId, Weight>(path)
+                        : read_edge_list<VertexId, Weight>(path);
+    return build_csr<EdgeOffset>(edges, options);
+}
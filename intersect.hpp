@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/*
+Intersection of sorted id lists, for triangle counting and SCAN.
+
+Both lists must be sorted ascending without duplicates. Every kernel comes
+as a count-only function and as one that writes the common ids, ascending,
+to `out`, which needs room for min(size_a, size_b) ids:
+
+    merge_intersect[_count]    linear merge with a branch-free step
+    gallop_intersect[_count]   each id of the shorter list is searched in the
+                               longer one by exponential then binary search,
+                               O(small * log(large / small))
+    simd_intersect[_count]     blocks of 4-byte ids compared all-pairs with
+                               AVX-512 (16 lanes) or AVX2 (8 lanes), the tail
+                               and any other build fall back to the merge
+
+intersect_count() and intersect() pick one of them: galloping once the longer
+list is gallop_ratio times the shorter one (intersect_bench.cpp measures the
+crossover), the SIMD blocks otherwise.
+ */
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+constexpr std::size_t gallop_ratio = 32;
+#else
+constexpr std::size_t gallop_ratio = 8;  // against the plain merge
+#endif
+
+template <typename VertexId>
+uint64_t merge_intersect_count(const VertexId *a, std::size_t size_a,
+                               const VertexId *b, std::size_t size_b) {
+    uint64_t count = 0;
+    std::size_t i = 0, j = 0;
+    while (i < size_a && j < size_b) {
+        // branch-free step, the comparisons are unpredictable
+        const auto x = a[i];
+        const auto y = b[j];
+        count += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return count;
+}
+
+template <typename VertexId>
+std::size_t merge_intersect(const VertexId *a, std::size_t size_a,
+                            const VertexId *b, std::size_t size_b,
+                            VertexId *out) {
+    std::size_t count = 0, i = 0, j = 0;
+    while (i < size_a && j < size_b) {
+        // out[count] is only kept if it matched; it is in bounds because the
+        // loop ends once the shorter list is used up
+        const auto x = a[i];
+        const auto y = b[j];
+        out[count] = x;
+        count += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return count;
+}
+
+namespace intersect_detail {
+
+// First position >= from in large[0, size) holding an id >= x
+template <typename VertexId>
+std::size_t gallop(const VertexId *large, std::size_t size, std::size_t from,
+                   VertexId x) {
+    std::size_t bound = 1;
+    while (from + bound < size && large[from + bound] < x) {
+        bound *= 2;
+    }
+    // large[from + bound / 2] < x was already checked
+    return std::lower_bound(large + from + bound / 2,
+                            large + std::min(size, from + bound + 1), x) -
+           large;
+}
+
+// Calls on_match(x) for each common id, walking the shorter list
+template <typename VertexId, typename OnMatch>
+void gallop_each(const VertexId *a, std::size_t size_a, const VertexId *b,
+                 std::size_t size_b, OnMatch on_match) {
+    if (size_a > size_b) {
+        std::swap(a, b);
+        std::swap(size_a, size_b);
+    }
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < size_a && j < size_b; i++) {
+        j = gallop(b, size_b, j, a[i]);
+        if (j < size_b && b[j] == a[i]) {
+            on_match(a[i]);
+            j++;
+        }
+    }
+}
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+// Permutation that moves the lanes set in an 8-bit mask to the front, packed
+// as eight 4-bit lane indices per mask
+constexpr std::array<uint32_t, 256> make_compress_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t mask = 0; mask < 256; mask++) {
+        uint32_t packed = 0;
+        int slot = 0;
+        for (uint32_t lane = 0; lane < 8; lane++) {
+            if (mask & (1u << lane)) {
+                packed |= lane << (4 * slot++);
+            }
+        }
+        table[mask] = packed;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint32_t, 256> compress_table =
+    make_compress_table();
+
+// Stores the lanes of `values` selected by `mask` contiguously at out
+inline void compress_store(int32_t *out, __m256i values, int mask) {
+    const __m256i shifts = _mm256_set_epi32(28, 24, 20, 16, 12, 8, 4, 0);
+    const __m256i permutation = _mm256_and_si256(
+        _mm256_srlv_epi32(_mm256_set1_epi32(compress_table[mask]), shifts),
+        _mm256_set1_epi32(0xF));
+    // only the first popcount(mask) lanes are written
+    const __m256i keep = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(__builtin_popcount(mask)),
+        _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    _mm256_maskstore_epi32(out, keep,
+                           _mm256_permutevar8x32_epi32(values, permutation));
+}
+#endif
+
+// One block of a is compared against every rotation of one block of b, then
+// the block with the smaller last id advances; a common id sits in exactly
+// one block pair that is compared, so nothing is counted twice. on_block gets
+// the block of a and the mask of its matching lanes. Returns how far each
+// list got, the caller finishes the tail with the merge.
+template <typename VertexId, typename OnBlock>
+std::pair<std::size_t, std::size_t> simd_blocks(const VertexId *a,
+                                                std::size_t size_a,
+                                                const VertexId *b,
+                                                std::size_t size_b,
+                                                OnBlock on_block) {
+    std::size_t i = 0, j = 0;
+    if constexpr (sizeof(VertexId) == 4) {
+#if defined(__AVX512F__)
+        const __m512i rotate = _mm512_set_epi32(0, 15, 14, 13, 12, 11, 10, 9,
+                                                8, 7, 6, 5, 4, 3, 2, 1);
+        while (i + 16 <= size_a && j + 16 <= size_b) {
+            const __m512i block_a = _mm512_loadu_si512(a + i);
+            __m512i block_b = _mm512_loadu_si512(b + j);
+            __mmask16 match = 0;
+            for (int r = 0; r < 16; r++) {
+                match |= _mm512_cmpeq_epi32_mask(block_a, block_b);
+                block_b = _mm512_permutexvar_epi32(rotate, block_b);
+            }
+            on_block(block_a, match);
+            const auto last_a = a[i + 15];
+            const auto last_b = b[j + 15];
+            i += last_a <= last_b ? 16 : 0;
+            j += last_b <= last_a ? 16 : 0;
+        }
+#elif defined(__AVX2__)
+        const __m256i rotate = _mm256_set_epi32(0, 7, 6, 5, 4, 3, 2, 1);
+        while (i + 8 <= size_a && j + 8 <= size_b) {
+            const __m256i block_a = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(a + i));
+            __m256i block_b = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(b + j));
+            __m256i match = _mm256_setzero_si256();
+            for (int r = 0; r < 8; r++) {
+                match = _mm256_or_si256(match,
+                                        _mm256_cmpeq_epi32(block_a, block_b));
+                block_b = _mm256_permutevar8x32_epi32(block_b, rotate);
+            }
+            on_block(block_a,
+                     _mm256_movemask_ps(_mm256_castsi256_ps(match)));
+            const auto last_a = a[i + 7];
+            const auto last_b = b[j + 7];
+            i += last_a <= last_b ? 8 : 0;
+            j += last_b <= last_a ? 8 : 0;
+        }
+#endif
+    }
+    (void)a, (void)size_a, (void)b, (void)size_b, (void)on_block;
+    return {i, j};
+}
+
+}  // namespace intersect_detail
+
+template <typename VertexId>
+uint64_t gallop_intersect_count(const VertexId *a, std::size_t size_a,
+                                const VertexId *b, std::size_t size_b) {
+    uint64_t count = 0;
+    intersect_detail::gallop_each(a, size_a, b, size_b,
+                                  [&](VertexId) { count++; });
+    return count;
+}
+
+template <typename VertexId>
+std::size_t gallop_intersect(const VertexId *a, std::size_t size_a,
+                             const VertexId *b, std::size_t size_b,
+                             VertexId *out) {
+    std::size_t count = 0;
+    intersect_detail::gallop_each(a, size_a, b, size_b,
+                                  [&](VertexId x) { out[count++] = x; });
+    return count;
+}
+
+template <typename VertexId>
+uint64_t simd_intersect_count(const VertexId *a, std::size_t size_a,
+                              const VertexId *b, std::size_t size_b) {
+    uint64_t count = 0;
+    const auto [i, j] = intersect_detail::simd_blocks(
+        a, size_a, b, size_b,
+        [&](auto, unsigned mask) { count += __builtin_popcount(mask); });
+    return count + merge_intersect_count(a + i, size_a - i, b + j, size_b - j);
+}
+
+template <typename VertexId>
+std::size_t simd_intersect(const VertexId *a, std::size_t size_a,
+                           const VertexId *b, std::size_t size_b,
+                           VertexId *out) {
+    std::size_t count = 0;
+    const auto [i, j] = intersect_detail::simd_blocks(
+        a, size_a, b, size_b, [&](auto block, unsigned mask) {
+            // matches come out in the order of a, so ascending
+#if defined(__AVX512F__)
+            _mm512_mask_compressstoreu_epi32(out + count, mask, block);
+#elif defined(__AVX2__)
+            intersect_detail::compress_store(
+                reinterpret_cast<int32_t *>(out + count), block, mask);
+#endif
+            (void)block;
+            count += __builtin_popcount(mask);
+        });
+    return count + merge_intersect(a + i, size_a - i, b + j, size_b - j,
+                                   out + count);
+}
+
+// Count of common ids, with the kernel chosen by the size ratio
+template <typename VertexId>
+uint64_t intersect_count(const VertexId *a, std::size_t size_a,
+                         const VertexId *b, std::size_t size_b) {
+    if (size_a > size_b) {
+        std::swap(a, b);
+        std::swap(size_a, size_b);
+    }
+    if (size_a == 0 || a[size_a - 1] < b[0] || b[size_b - 1] < a[0]) {
+        return 0;
+    }
+    if (size_b / size_a >= gallop_ratio) {
+        return gallop_intersect_count(a, size_a, b, size_b);
+    }
+    return simd_intersect_count(a, size_a, b, size_b);
+}
+
+// Writes the common ids to out (room for min(size_a, size_b)), returns how
+// many; the kernel is chosen like in intersect_count()
+template <typename VertexId>
+std::size_t intersect(const VertexId *a, std::size_t size_a,
+                      const VertexId *b, std::size_t size_b, VertexId *out) {
+    if (size_a > size_b) {
+        std::swap(a, b);
+        std::swap(size_a, size_b);
+    }
+    if (size_a == 0 || a[size_a - 1] < b[0] || b[size_b - 1] < a[0]) {
+        return 0;
+    }
+    if (size_b / size_a >= gallop_ratio) {
+        return gallop_intersect(a, size_a, b, size_b, out);
+    }
+    return simd_intersect(a, size_a, b, size_b, out);
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "intersect.hpp"
+#include "rng.hpp"
+
+// Microbenchmark of the sorted-set intersection kernels in intersect.hpp.
+// For a range of size ratios it intersects random list pairs with every
+// kernel, count-only and materializing, and reports nanoseconds per pair;
+// where galloping starts to beat the SIMD blocks is the gallop_ratio to use.
+//
+//     intersect_bench [short list length] [pairs per ratio]
+
+// Sorted distinct ids drawn from [0, universe)
+std::vector<int> random_set(SplitMix64 &rng, std::size_t size,
+                            uint64_t universe) {
+    std::vector<int> set;
+    set.reserve(size + size / 8);
+    while (set.size() < size) {
+        while (set.size() < size) {
+            set.push_back(static_cast<int>(rng.next_below(universe)));
+        }
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+    }
+    return set;
+}
+
+struct ListPair {
+    std::vector<int> a, b;
+};
+
+template <typename Kernel>
+double time_ns(const std::vector<ListPair> &pairs, int repeats,
+               uint64_t &checksum, Kernel kernel) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (const auto &pair : pairs) {
+            checksum += kernel(pair);
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (double(repeats) * pairs.size());
+}
+
+int main(int argc, char **argv) {
+    const std::size_t short_size = argc > 1 ? std::stoul(argv[1]) : 64;
+    const std::size_t num_pairs = argc > 2 ? std::stoul(argv[2]) : 256;
+    SplitMix64 rng(42);
+    std::vector<int> out;
+
+    std::cout << "short list " << short_size << ", " << num_pairs
+              << " pairs per ratio, ns per pair\n";
+    std::cout << std::setw(6) << "ratio" << std::setw(9) << "common";
+    for (const char *name : {"merge", "gallop", "simd", "auto"}) {
+        std::cout << std::setw(9) << name << std::setw(9) << "+out";
+    }
+    std::cout << "\n";
+
+    for (std::size_t ratio : {1, 2, 4, 8, 16, 32, 64, 128, 256, 1024}) {
+        const std::size_t long_size = short_size * ratio;
+        // a universe of 4x the long list: about a quarter of the short list
+        // is common, as between neighborhoods in a clustered graph
+        std::vector<ListPair> pairs(num_pairs);
+        for (auto &pair : pairs) {
+            pair.a = random_set(rng, short_size, 4 * long_size);
+            pair.b = random_set(rng, long_size, 4 * long_size);
+        }
+        out.resize(short_size);
+        const int repeats = std::max<std::size_t>(
+            1, (std::size_t(1) << 24) / (num_pairs * (short_size + long_size)));
+
+        uint64_t expected = 0;
+        for (const auto &pair : pairs) {
+            expected += merge_intersect_count(pair.a.data(), pair.a.size(),
+                                              pair.b.data(), pair.b.size());
+        }
+        std::cout << std::setw(6) << ratio << std::setw(9) << std::fixed
+                  << std::setprecision(1) << double(expected) / num_pairs;
+
+        auto report = [&](auto count, auto materialize) {
+            uint64_t counted = 0, written = 0;
+            const double count_ns = time_ns(pairs, repeats, counted, count);
+            const double out_ns =
+                time_ns(pairs, repeats, written, materialize);
+            std::cout << std::setw(9) << count_ns << std::setw(9) << out_ns;
+            if (counted != expected * repeats || written != expected * repeats) {
+                std::cerr << "\nmismatch at ratio " << ratio << "\n";
+                std::exit(1);
+            }
+        };
+#define KERNEL(count_fn, out_fn)                                          \
+    report(                                                               \
+        [](const ListPair &p) {                                           \
+            return uint64_t(count_fn(p.a.data(), p.a.size(), p.b.data(),  \
+                                     p.b.size()));                        \
+        },                                                                \
+        [&out](const ListPair &p) {                                       \
+            return uint64_t(out_fn(p.a.data(), p.a.size(), p.b.data(),    \
+                                   p.b.size(), out.data()));              \
+        })
+        KERNEL(merge_intersect_count, merge_intersect);
+        KERNEL(gallop_intersect_count, gallop_intersect);
+        KERNEL(simd_intersect_count, simd_intersect);
+        KERNEL(intersect_count, intersect);
+#undef KERNEL
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -1,8 +1,19 @@
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <queue>
+#include <stdexcept>
 #include <vector>
 
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "rng.hpp"
+
 /*
 The Low-Diameter Decomposition (LDD) algorithm is a graph partitioning algorithm
 that decomposes a graph into several connected subgraphs (or components) such
@@ -19,20 +30,22 @@ until the diameter of the set reaches a specified threshold beta.
 5. Repeat steps 2-4 until all nodes have
 been visited and assigned to a set.
  */
-std::vector<int> lowDiameterDecomposition(const std::vector<int> row_ptr,
-                                          const std::vector<int> col_idx,
-                                          const int beta) {
-    int num_nodes = row_ptr.size() - 1;
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<int> lowDiameterDecomposition(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph, const int beta) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
     std::vector<int> components(num_nodes, -1);
     std::vector<bool> visited(num_nodes, false);
-    std::queue<int> bfs_queue;
+    std::queue<VertexId> bfs_queue;
 
     int set_id = 0;
-    for (int source = 0; source < num_nodes; source++) {
+    for (std::size_t source = 0; source < num_nodes; source++) {
         if (!visited[source]) {
             int set_size = 0;
 
-            bfs_queue.push(source);
+            bfs_queue.push(static_cast<VertexId>(source));
             visited[source] = true;
             components[source] = set_id;
 
@@ -67,20 +80,224 @@ std::vector<int> lowDiameterDecomposition(const std::vector<int> row_ptr,
     return components;
 }
 
-int main() {
+/*
+ * Parallel low-diameter decomposition (Miller, Peng, Xu 2013)
+ *
+ * Every vertex v draws a shift delta_v ~ Exponential(beta) and would start
+ * its own BFS at time delta_max - delta_v; v ends up in the cluster of the
+ * center u minimizing dist(u, v) - delta_u. With high probability:
+ *  - every cluster is connected and has radius at most delta_max + 1 =
+ *    O(log n / beta) from its center, measured inside the cluster, so its
+ *    strong diameter is at most twice that;
+ *  - each edge is cut with probability O(beta), so O(beta * m) edges run
+ *    between clusters in expectation.
+ * Smaller beta gives fewer, larger clusters and fewer cut edges.
+ *
+ * All BFSs run at once, one frontier round per time unit: round r adds the
+ * unclaimed vertices whose start time rounds down to r as new centers, and
+ * the unclaimed neighbors of the frontier. A vertex reached from several
+ * centers in the same round write_min()s their rank by the fractional part
+ * of their start time (radix-sorted once), so it joins the center with the
+ * smallest dist(u, v) - delta_u. The clusters are exactly the ones of the
+ * definition for any number of threads.
+ *
+ * require:
+ * Undirected Graph
+ */
+template <typename VertexId>
+struct LDDClusters {
+    std::vector<VertexId> cluster;       // cluster id of every vertex
+    std::vector<VertexId> center;        // center vertex of every cluster
+    std::vector<std::size_t> size;       // vertices in every cluster
+    std::vector<std::size_t> cut_edges;  // edges leaving every cluster
+    std::size_t total_cut_edges = 0;     // undirected, between clusters
+    uint32_t max_radius = 0;             // BFS rounds from a center
+};
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+LDDClusters<VertexId> mpx_decomposition(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph, double beta,
+    uint64_t seed = 0) {
+    if (!(beta > 0 && beta <= 1)) {
+        throw std::invalid_argument("MPX decomposition needs 0 < beta <= 1");
+    }
+    constexpr VertexId unclaimed =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    constexpr uint64_t no_claim = std::numeric_limits<uint64_t>::max();
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+
+    // >> Start times
+    std::vector<double> start(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        // 1 - U is in (0, 1], so the log is finite
+        start[v] = -std::log(1 - SplitMix64(seed, v).next_double()) / beta;
+    }
+    double max_shift = 0;
+#pragma omp parallel for reduction(max : max_shift)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        max_shift = std::max(max_shift, start[v]);
+    }
+    // by_round: the vertices by the round they start in; by_fraction: by the
+    // fractional part of their start time, which breaks ties within a round
+    std::vector<uint32_t> start_round(num_nodes);
+    std::vector<double> fraction(num_nodes);
+    std::vector<VertexId> by_round(num_nodes), by_fraction(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        start[v] = max_shift - start[v];
+        start_round[v] = static_cast<uint32_t>(start[v]);
+        fraction[v] = start[v] - start_round[v];
+        by_round[v] = by_fraction[v] = v;
+    }
+    radix_sort_stable(start_round.data(), by_round.data(), num_nodes);
+    radix_sort_stable(fraction.data(), by_fraction.data(), num_nodes);
+    std::vector<uint64_t> rank(num_nodes);
+#pragma omp parallel for
+    for (std::size_t k = 0; k < num_nodes; k++) {
+        rank[by_fraction[k]] = k;
+    }
+
+    // >> Rounds; owner[v] is the center of v's cluster
+    std::vector<VertexId> owner(num_nodes, unclaimed);
+    std::vector<uint32_t> depth(num_nodes, 0);  // round v was claimed in
+    std::vector<uint64_t> claim(num_nodes, no_claim);
+    std::vector<VertexId> frontier, candidates;
+    std::size_t next_start = 0;  // first vertex of by_round not yet started
+    for (uint32_t round = 0; next_start < num_nodes || !frontier.empty();
+         round++) {
+        // the vertices starting this round, then the frontier's neighbors
+        std::size_t end_start = next_start;
+        while (end_start < num_nodes && start_round[end_start] == round) {
+            end_start++;
+        }
+        candidates.clear();
+#pragma omp parallel
+        {
+            std::vector<VertexId> local;
+#pragma omp for nowait
+            for (std::size_t k = next_start; k < end_start; k++) {
+                const VertexId v = by_round[k];
+                if (atomic_load(owner[v]) == unclaimed) {
+                    write_min(claim[v], rank[v]);
+                    local.push_back(v);
+                }
+            }
+#pragma omp for schedule(dynamic, 256) nowait
+            for (std::size_t k = 0; k < frontier.size(); k++) {
+                const VertexId u = frontier[k];
+                const uint64_t key = rank[owner[u]];
+                for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+                    const VertexId v = col_idx[i];
+                    if (atomic_load(owner[v]) == unclaimed &&
+                        write_min(claim[v], key)) {
+                        local.push_back(v);
+                    }
+                }
+            }
+#pragma omp critical
+            candidates.insert(candidates.end(), local.begin(), local.end());
+        }
+        next_start = end_start;
+
+        // every claimed vertex joins the center with the earliest fraction
+        // among those that reached it
+        frontier.clear();
+#pragma omp parallel
+        {
+            std::vector<VertexId> local;
+#pragma omp for nowait
+            for (std::size_t k = 0; k < candidates.size(); k++) {
+                const VertexId v = candidates[k];
+                const VertexId center = by_fraction[atomic_load(claim[v])];
+                if (compare_and_swap(owner[v], unclaimed, center)) {
+                    depth[v] = round;
+                    local.push_back(v);
+                }
+            }
+#pragma omp critical
+            frontier.insert(frontier.end(), local.begin(), local.end());
+        }
+    }
+
+    // >> Cluster ids in center id order, sizes and cut edges
+    std::vector<VertexId> is_center(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        is_center[v] = owner[v] == static_cast<VertexId>(v);
+    }
+    const auto cluster_id = prefix_sum<VertexId>(is_center);
+    const std::size_t num_clusters = cluster_id[num_nodes];
+
+    LDDClusters<VertexId> result;
+    result.cluster.resize(num_nodes);
+    result.center.resize(num_clusters);
+    result.size.assign(num_clusters, 0);
+    result.cut_edges.assign(num_clusters, 0);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        result.cluster[v] = cluster_id[owner[v]];
+        if (is_center[v]) {
+            result.center[cluster_id[v]] = v;
+        }
+    }
+    std::size_t total_cut = 0;
+    uint32_t max_radius = 0;
+#pragma omp parallel for schedule(dynamic, 1024) \
+    reduction(+ : total_cut) reduction(max : max_radius)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        const VertexId c = result.cluster[v];
+        std::size_t cut = 0;
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            cut += result.cluster[col_idx[i]] != c;
+        }
+        fetch_and_add(result.size[c], std::size_t(1));
+        if (cut > 0) {
+            fetch_and_add(result.cut_edges[c], cut);
+        }
+        total_cut += cut;
+        max_radius = std::max(max_radius, depth[v] - depth[owner[v]]);
+    }
+    result.total_cut_edges = total_cut / 2;
+    result.max_radius = max_radius;
+    return result;
+}
+
+int main(int argc, char **argv) {
     // A cycle of 3 nodes: 0 -> 1 -> 2 -> 0
     // A cycle of 3 nodes: 3 -> 4 -> 5 -> 3
     std::vector<int> row_ptr = {0, 1, 2, 3, 4, 5, 6};
     std::vector<int> col_idx = {1, 2, 0, 4, 5, 3};
+    CSRGraph<> graph(row_ptr, col_idx);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
     int beta = 2;
 
-    auto components = lowDiameterDecomposition(row_ptr, col_idx, beta);
+    auto components = lowDiameterDecomposition(graph, beta);
 
     // Print the decomposition
-    for (int i = 0; i < components.size(); ++i) {
+    for (size_t i = 0; i < components.size(); ++i) {
         std::cout << "Node " << i << " is in set " << components[i]
                   << std::endl;
     }
 
+    const double mpx_beta = 0.2;
+    const auto clusters = mpx_decomposition(graph, mpx_beta);
+    std::cout << "MPX, beta " << mpx_beta << ": " << clusters.center.size()
+              << " clusters, " << clusters.total_cut_edges
+              << " cut edges, max radius " << clusters.max_radius
+              << std::endl;
+    if (argc <= 1) {
+        for (std::size_t c = 0; c < clusters.center.size(); c++) {
+            std::cout << "Cluster " << c << ": center " << clusters.center[c]
+                      << ", " << clusters.size[c] << " vertices, "
+                      << clusters.cut_edges[c] << " edges out" << std::endl;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "rng.hpp"
+
+/*
+Parallel maximal matching, used on its own (mm.cpp) and to coarsen graphs for
+multilevel partitioning (partition.cpp).
+
+Both variants work on the undirected edges (u < v, self loops dropped) in
+rounds of reserve / commit: every edge of the round with two free
+endpoints write_min()s its key into the reservation slot of both, the
+edges that hold both slots are matched, and edges with a matched endpoint
+are dropped.
+ - Luby (Israeli-Itai): every round takes all remaining edges with fresh
+   random keys, so the matched edges are the local minima; O(log n) rounds
+   in expectation.
+ - DeterministicReservations (Blelloch et al.): every edge gets one key up
+   front and each round takes the edges that lost the last round plus the
+   next slice of keys. The result is exactly the serial greedy matching in
+   key order, so it only depends on the seed. Rounds only need to be
+   prefixes in key order, not sorted, so keys are split into slices by
+   their top bits in one partition pass instead of a sort.
+heavy_edges puts the weight bucket in the top bits of the key, heavier
+first, as used for coarsening: weights within a factor of sqrt(2) share a
+bucket (32 buckets down from the heaviest edge, the last one takes the
+rest) and are ordered randomly. A strict weight order would let a path
+with increasing weights match one edge per round, quadratic work; with
+buckets the rounds grow by at most the number of buckets in use.
+Unweighted graphs ignore it.
+Both return the matched edges as (u, v) pairs with u < v, sorted.
+ */
+enum class MatchingMode { Luby, DeterministicReservations };
+
+struct MatchingOptions {
+    MatchingMode mode = MatchingMode::DeterministicReservations;
+    bool heavy_edges = false;
+    uint64_t seed = 0;
+};
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<std::pair<VertexId, VertexId>> parallel_maximal_matching(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    MatchingOptions options = {}) {
+    constexpr bool is_weighted =
+        CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted;
+    constexpr uint64_t unreserved = std::numeric_limits<uint64_t>::max();
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+
+    // >> Undirected edges, from the smaller end
+    std::vector<EdgeOffset> count(num_nodes);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        EdgeOffset c = 0;
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            c += static_cast<std::size_t>(col_idx[i]) > u;
+        }
+        count[u] = c;
+    }
+    const auto edge_start = prefix_sum<EdgeOffset>(count);
+    std::vector<EdgeOffset>().swap(count);
+    const std::size_t num_edges = edge_start[num_nodes];
+    std::vector<VertexId> source(num_edges), target(num_edges);
+    std::vector<uint64_t> noise(num_edges);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        auto e = edge_start[u];
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const uint64_t v = col_idx[i];
+            if (v > u) {
+                source[e] = u;
+                target[e] = v;
+                noise[e] = SplitMix64(options.seed ^ (uint64_t(u) << 32 | v), v)();
+                e++;
+            }
+        }
+    }
+
+    // heavy_edges: 5-bit weight bucket of each edge, 0 for the heaviest
+    constexpr int bucket_bits = 5;
+    const bool heavy = is_weighted && options.heavy_edges;
+    std::vector<uint8_t> bucket;
+    if constexpr (is_weighted) {
+        if (heavy) {
+            double max_weight = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(max : max_weight)
+            for (std::size_t u = 0; u < num_nodes; u++) {
+                for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+                    max_weight = std::max<double>(max_weight,
+                                                  graph.values()[i]);
+                }
+            }
+            constexpr int last = (1 << bucket_bits) - 1;
+            bucket.resize(num_edges);
+#pragma omp parallel for schedule(dynamic, 1024)
+            for (std::size_t u = 0; u < num_nodes; u++) {
+                auto e = edge_start[u];
+                for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+                    if (static_cast<std::size_t>(col_idx[i]) > u) {
+                        const double w = graph.values()[i];
+                        bucket[e] =
+                            w > 0 ? std::min<double>(
+                                        last, 2 * std::log2(max_weight / w))
+                                  : last;
+                        e++;
+                    }
+                }
+            }
+        }
+    }
+
+    // random high bits (below the bucket), the edge id in the low ones
+    // keeps keys unique
+    int id_bits = 0;
+    while (id_bits < 64 && (uint64_t(1) << id_bits) < num_edges) {
+        id_bits++;
+    }
+    const uint64_t id_mask =
+        id_bits == 64 ? ~uint64_t(0) : (uint64_t(1) << id_bits) - 1;
+    auto random_key = [&](EdgeOffset e, uint64_t round) {
+        uint64_t bits = round == 0 ? noise[e] : SplitMix64(noise[e], round)();
+        if (heavy) {
+            bits = uint64_t(bucket[e]) << (64 - bucket_bits) |
+                   bits >> bucket_bits;
+        }
+        return (bits & ~id_mask) | uint64_t(e);
+    };
+
+    std::vector<uint64_t> reservation(num_nodes, unreserved);
+    std::vector<uint8_t> matched(num_nodes, 0);
+    std::vector<std::pair<VertexId, VertexId>> matching;
+    // One reserve / commit round over the edges batch[0, size), key_of() must
+    // be unique within the round. Leaves the edges still worth trying at the
+    // front of batch and returns how many.
+    auto run_round = [&](EdgeOffset *batch, std::size_t size, auto key_of) {
+        // entries whose edge still has two free endpoints reserve them
+        std::vector<uint8_t> live(size);
+#pragma omp parallel for
+        for (std::size_t k = 0; k < size; k++) {
+            const auto e = batch[k];
+            live[k] = !matched[source[e]] && !matched[target[e]];
+            if (live[k]) {
+                const uint64_t key = key_of(e);
+                write_min(reservation[source[e]], key);
+                write_min(reservation[target[e]], key);
+            }
+        }
+        // the winners have both endpoints to themselves
+#pragma omp parallel
+        {
+            std::vector<std::pair<VertexId, VertexId>> local_matching;
+#pragma omp for nowait
+            for (std::size_t k = 0; k < size; k++) {
+                const auto e = batch[k];
+                if (!live[k]) {
+                    continue;
+                }
+                const uint64_t key = key_of(e);
+                if (reservation[source[e]] == key &&
+                    reservation[target[e]] == key) {
+                    matched[source[e]] = matched[target[e]] = 1;
+                    local_matching.emplace_back(source[e], target[e]);
+                }
+            }
+#pragma omp critical
+            matching.insert(matching.end(), local_matching.begin(),
+                            local_matching.end());
+        }
+#pragma omp parallel for
+        for (std::size_t k = 0; k < size; k++) {
+            if (live[k]) {
+                const auto e = batch[k];
+                atomic_store(reservation[source[e]], unreserved);
+                atomic_store(reservation[target[e]], unreserved);
+                live[k] = !matched[source[e]] && !matched[target[e]];
+            }
+        }
+        std::size_t kept = 0;
+        for (std::size_t k = 0; k < size; k++) {
+            if (live[k]) {
+                batch[kept++] = batch[k];
+            }
+        }
+        return kept;
+    };
+
+    if (options.mode == MatchingMode::Luby) {
+        std::vector<EdgeOffset> live(num_edges);
+#pragma omp parallel for
+        for (std::size_t e = 0; e < num_edges; e++) {
+            live[e] = e;
+        }
+        std::size_t size = num_edges;
+        for (uint64_t round = 0; size > 0; round++) {
+            size = run_round(live.data(), size, [&](EdgeOffset e) {
+                return random_key(e, round);
+            });
+        }
+        std::sort(matching.begin(), matching.end());
+        return matching;
+    }
+
+    // >> Deterministic reservations: the edges in slices of increasing keys
+    const std::size_t step = std::max<std::size_t>(4096, num_nodes / 8);
+    std::vector<EdgeOffset> order(num_edges);
+    std::vector<std::size_t> slice_start;
+    // partition by the top bits of the key, per-block histograms
+    int slice_bits = 0;
+    while (slice_bits < 16 && (num_edges >> slice_bits) > step) {
+        slice_bits++;
+    }
+    const std::size_t num_slices = std::size_t(1) << slice_bits;
+    auto slice_of = [&](EdgeOffset e) {
+        return slice_bits == 0 ? 0 : random_key(e, 0) >> (64 - slice_bits);
+    };
+    const std::size_t num_blocks = num_threads();
+    std::vector<std::size_t> histogram(num_blocks * num_slices, 0);
+#pragma omp parallel for schedule(static, 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        auto *count = histogram.data() + b * num_slices;
+        for (std::size_t e = num_edges * b / num_blocks;
+             e < num_edges * (b + 1) / num_blocks; e++) {
+            count[slice_of(e)]++;
+        }
+    }
+    // histogram[b][s] becomes the first slot of block b in slice s
+    std::size_t running = 0;
+    for (std::size_t slice = 0; slice < num_slices; slice++) {
+        slice_start.push_back(running);
+        for (std::size_t b = 0; b < num_blocks; b++) {
+            const auto count = histogram[b * num_slices + slice];
+            histogram[b * num_slices + slice] = running;
+            running += count;
+        }
+    }
+#pragma omp parallel for schedule(static, 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        auto *cursor = histogram.data() + b * num_slices;
+        for (std::size_t e = num_edges * b / num_blocks;
+             e < num_edges * (b + 1) / num_blocks; e++) {
+            order[cursor[slice_of(e)]++] = e;
+        }
+    }
+    slice_start.push_back(num_edges);
+
+    // edges that lost a round have smaller keys than every later slice
+    std::vector<EdgeOffset> batch;
+    std::size_t size = 0;
+    for (std::size_t slice = 0; slice + 1 < slice_start.size(); slice++) {
+        batch.resize(size);
+        batch.insert(batch.end(), order.begin() + slice_start[slice],
+                     order.begin() + slice_start[slice + 1]);
+        size = batch.size();
+        do {
+            size = run_round(batch.data(), size, [&](EdgeOffset e) {
+                return random_key(e, 0);
+            });
+        } while (size > 0 && slice + 2 == slice_start.size());
+    }
+    std::sort(matching.begin(), matching.end());
+    return matching;
+}
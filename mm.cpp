@@ -2,6 +2,11 @@
 #include <algorithm>
 #include <iostream>
 #include <vector>
+
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "matching.hpp"
+
 /*
 The Maximal Matching algorithm is a graph algorithm that finds a matching in a
 graph, where a matching is a set of edges without common vertices.
@@ -24,28 +29,31 @@ require:
 Undirected Unweighted Graph
  */
 
-auto maximal_matching(const std::vector<int> &row_ptr,
-                      const std::vector<int> &col_idx) {
-    int num_nodes = row_ptr.size() - 1;
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto maximal_matching(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
     std::vector<bool> matched(num_nodes, false);
-    std::vector<std::pair<int, int>> edges;
+    std::vector<std::pair<VertexId, VertexId>> edges;
 
-    for (int source = 0; source < num_nodes; source++) {
+    for (std::size_t source = 0; source < num_nodes; source++) {
         if (matched[source])
             continue;
-        for (int j = row_ptr[source]; j < row_ptr[source + 1]; j++) {
+        for (auto j = row_ptr[source]; j < row_ptr[source + 1]; j++) {
             auto target = col_idx[j];
             if (matched[target])
                 continue;
             matched[source] = true;
             matched[target] = true;
-            edges.emplace_back(source, target);
+            edges.emplace_back(static_cast<VertexId>(source), target);
             break;
         }
     }
     return edges;
 }
-int main() {
+
+int main(int argc, char **argv) {
     /* Graph:
     0 -- 1
     |    |
@@ -56,12 +64,37 @@ int main() {
     std::vector<int> rowPtr = {0, 2, 4, 6, 8, 10};
     std::vector<int> colIndex = {1, 3, 0, 2, 1, 4, 0, 4, 2, 3};
 
-    auto edges = maximal_matching(rowPtr, colIndex);
+    CSRGraph<> graph(rowPtr, colIndex);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
+
+    auto edges = maximal_matching(graph);
 
     // Print the result
     for (const auto &edge : edges) {
         std::cout << edge.first << " " << edge.second << std::endl;
     }
 
+    for (const auto mode :
+         {MatchingMode::Luby, MatchingMode::DeterministicReservations}) {
+        std::cout << (mode == MatchingMode::Luby ? "Luby:"
+                                                 : "deterministic reservations:")
+                  << std::endl;
+        for (const auto &edge : parallel_maximal_matching(graph, {mode})) {
+            std::cout << edge.first << " " << edge.second << std::endl;
+        }
+    }
+
+    // heavy edges first: 2 - 4 and 0 - 3 outweigh the rest
+    std::vector<int> weights = {1, 5, 1, 1, 1, 7, 5, 1, 7, 1};
+    CSRGraph<int, int, int> weighted(rowPtr, colIndex, weights);
+    std::cout << "heavy-edge matching:" << std::endl;
+    for (const auto &edge : parallel_maximal_matching(
+             weighted, {MatchingMode::DeterministicReservations, true})) {
+        std::cout << edge.first << " " << edge.second << std::endl;
+    }
+
     return 0;
 }
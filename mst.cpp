@@ -1,31 +1,50 @@
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <queue>
+#include <tuple>
 #include <vector>
 #include <numeric>
+
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "priority_queues.hpp"
+#include "radix_sort.hpp"
+#include "rng.hpp"
+#include "union_find.hpp"
 //------------//
 // Priority Queue
 // Prim's algorithm to find the minimum spanning tree
+// The default queue has decrease-key, so every vertex is queued at most once
 //------------//
-auto Prim(const std::vector<int>& row_pointer, const std::vector<int>& column_index, const std::vector<float>& values)
+template <template <typename, typename> class Queue = IndexedDaryHeap, typename VertexId, typename EdgeOffset,
+          typename Weight>
+auto Prim(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
 {
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "Prim requires a weighted graph");
+  static_assert(!Queue<VertexId, Weight>::monotone, "Prim's keys are not monotone, use a general queue");
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto* values       = graph.values();
   // the same setting as Dijkstra's SSSP
-  const auto         num_nodes = row_pointer.size() - 1;
-  std::vector<float> distance(num_nodes, std::numeric_limits<float>::max());
-  std::vector<int>   parent(num_nodes, -1);
-  std::vector<bool>  visited(num_nodes, false);
-  std::priority_queue<
-      std::pair<float, int>,
-      std::vector<std::pair<float, int>>,
-      std::greater<std::pair<float, int>>>
-      min_heap;
+  const auto            num_nodes = graph.num_nodes();
+  std::vector<Weight>   distance(num_nodes, std::numeric_limits<Weight>::max());
+  std::vector<VertexId> parent(num_nodes, CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex);
+  std::vector<bool>     visited(num_nodes, false);
+  Queue<VertexId, Weight> min_heap(num_nodes, Weight(0));
   // start from vertex 0
-  min_heap.push({ 0.0, 0 });
-  distance[0] = 0.0;
+  min_heap.push(VertexId(0), Weight(0));
+  distance[0] = Weight(0);
 
   while(!min_heap.empty())
   {
-    auto [dist, source] = min_heap.top();
-    min_heap.pop();
+    auto [dist, source] = min_heap.pop();
+    if(visited[source])    // stale entry, only from queues without decrease-key
+    {
+      continue;
+    }
     visited[source] = true;
 
     // iterate over all outgoing edges
@@ -38,7 +57,7 @@ auto Prim(const std::vector<int>& row_pointer, const std::vector<int>& column_in
       {
         distance[target] = weight;
         parent[target]   = source;
-        min_heap.push({ weight, target });
+        min_heap.push(target, weight);
       }
     }
   }
@@ -47,34 +66,41 @@ auto Prim(const std::vector<int>& row_pointer, const std::vector<int>& column_in
 //------------//
 // Union Find //
 //------------//
-auto Kruskal(const std::vector<int>& row_pointer, const std::vector<int>& column_index, const std::vector<float>& values){
-  auto num_nodes = row_pointer.size() - 1;
-  auto num_edges = column_index.size();
-  std::vector<std::tuple<int, int, float>> edges;
-  std::vector<std::tuple<int, int, float>> tree;
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Kruskal(const CSRGraph<VertexId, EdgeOffset, Weight>& graph){
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "Kruskal requires a weighted graph");
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto* values       = graph.values();
+  auto num_nodes = graph.num_nodes();
+  auto num_edges = graph.num_edges();
+  std::vector<std::tuple<VertexId, VertexId, Weight>> tree;
 
-  for(int i = 0; i < num_nodes; i++) {
+  // O(E) radix sort of the weights, carrying the edge ids -- the most
+  // expensive part. It is stable, so equal weights keep their CSR order.
+  std::vector<Weight>     weights(values, values + num_edges);
+  std::vector<EdgeOffset> order(num_edges);
+  std::iota(order.begin(), order.end(), EdgeOffset(0));
+  radix_sort_stable(weights.data(), order.data(), num_edges);
+  std::vector<VertexId> sources(num_edges);
+  for(std::size_t i = 0; i < num_nodes; i++) {
     for(auto j = row_pointer[i]; j < row_pointer[i + 1]; j++){
-      edges.emplace_back(i, column_index[j], values[j]);
+      sources[j] = static_cast<VertexId>(i);
     }
   }
-  // O(ElogE) -- the most expensive part
-  std::sort(edges.begin(), edges.end(), [](auto& a, auto& b){
-    return std::get<2>(a) < std::get<2>(b);
-  });
   // Code below here are similar to Union Find in cc.cpp
-  std::vector<int> parent(num_nodes);
-  std::vector<int> rank(num_nodes);    // keep tree relatively balanced
+  std::vector<VertexId> parent(num_nodes);
+  std::vector<int>      rank(num_nodes);    // keep tree relatively balanced
   std::iota(parent.begin(), parent.end(), 0);
   // find 
-  auto find = [&parent](int i) {
+  auto find = [&parent](VertexId i) {
     while(parent[i] != i){
       i = parent[i];
     }
     return i;
   };
 
-  auto unite = [&find, &rank, &parent](int i, int j) {
+  auto unite = [&find, &rank, &parent](VertexId i, VertexId j) {
     i = find(i);
     j = find(j);
     if(rank[i] > rank[j]) {
@@ -86,7 +112,10 @@ auto Kruskal(const std::vector<int>& row_pointer, const std::vector<int>& column
     }
   };
   // O(ElogV) 
-  for(const auto [source, target, weight] : edges) {
+  for(std::size_t k = 0; k < num_edges; k++) {
+    const auto source = sources[order[k]];
+    const auto target = column_index[order[k]];
+    const auto weight = weights[k];
     if(find(source) != find(target)) {
       unite(source, target);
       tree.emplace_back(source, target, weight);
@@ -95,23 +124,301 @@ auto Kruskal(const std::vector<int>& row_pointer, const std::vector<int>& column
   return tree;
 }
 
-int main()
+//------------//
+// Parallel MST engines
+// Boruvka() and FilterKruskal() both work on the undirected edges, stored once
+// with source < target (self loops dropped), and order them by
+// (weight, source, target). That order is total up to exact duplicates, so the
+// minimum spanning forest is unique and both return the same edge list,
+// sorted in that order. The forest is kept in the lock-free union-find of
+// union_find.hpp (roots are the smallest member).
+//  - Boruvka: every round each component claims its lightest outgoing edge
+//    with a compare-and-swap min, the claimed edges are linked, and edges
+//    inside a component are dropped. O(log n) rounds over the remaining edges.
+//  - FilterKruskal (Osipov, Sanders, Singler): split the edges around a
+//    sampled pivot, solve the light half recursively, then drop the heavy
+//    edges that already lie inside a component before recursing on them. Only
+//    edges that can still join the forest are ever sorted, which on graphs
+//    with m >> n is a small fraction of them.
+//------------//
+template <typename VertexId, typename Weight>
+struct MSTEdge
+{
+  Weight   weight;
+  VertexId source;
+  VertexId target;
+
+  bool operator<(const MSTEdge& other) const
+  {
+    return std::tie(weight, source, target) < std::tie(other.weight, other.source, other.target);
+  }
+};
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto mst_edges(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "MST requires a weighted graph");
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto* values       = graph.values();
+  const auto  num_nodes    = graph.num_nodes();
+
+  std::vector<EdgeOffset> count(num_nodes);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    EdgeOffset c = 0;
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
+    {
+      c += static_cast<std::size_t>(column_index[i]) > u;
+    }
+    count[u] = c;
+  }
+  const auto edge_start = prefix_sum<EdgeOffset>(count);
+  std::vector<EdgeOffset>().swap(count);
+  std::vector<MSTEdge<VertexId, Weight>> edges(edge_start[num_nodes]);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    auto e = edge_start[u];
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
+    {
+      if(static_cast<std::size_t>(column_index[i]) > u)
+      {
+        edges[e++] = {values[i], static_cast<VertexId>(u), column_index[i]};
+      }
+    }
+  }
+  return edges;
+}
+
+// Stable parallel split of edges[0, size): the edges with keep(e) move to the
+// front, in order, the others behind them if `rest` is set, otherwise they are
+// dropped. Returns how many were kept. Small ranges run on one thread.
+template <typename Edge, typename Keep>
+std::size_t mst_split(Edge* edges, std::size_t size, std::vector<Edge>& scratch, bool rest, Keep keep)
+{
+  const bool        parallel   = size > (1 << 16);
+  const std::size_t num_blocks = parallel ? num_threads() : 1;
+  std::vector<std::size_t> kept(num_blocks + 1, 0), dropped(num_blocks + 1, 0);
+  scratch.resize(std::max(scratch.size(), size));
+#pragma omp parallel for if(parallel)
+  for(std::size_t b = 0; b < num_blocks; b++)
+  {
+    for(std::size_t k = size * b / num_blocks; k < size * (b + 1) / num_blocks; k++)
+    {
+      (keep(edges[k]) ? kept : dropped)[b + 1]++;
+    }
+  }
+  for(std::size_t b = 0; b < num_blocks; b++)
+  {
+    kept[b + 1] += kept[b];
+    dropped[b + 1] += dropped[b];
+  }
+  const std::size_t num_kept = kept[num_blocks];
+#pragma omp parallel for if(parallel)
+  for(std::size_t b = 0; b < num_blocks; b++)
+  {
+    auto front = kept[b], back = num_kept + dropped[b];
+    for(std::size_t k = size * b / num_blocks; k < size * (b + 1) / num_blocks; k++)
+    {
+      if(keep(edges[k]))
+      {
+        scratch[front++] = edges[k];
+      }
+      else if(rest)
+      {
+        scratch[back++] = edges[k];
+      }
+    }
+  }
+  const std::size_t copied = rest ? size : num_kept;
+#pragma omp parallel for if(parallel)
+  for(std::size_t k = 0; k < copied; k++)
+  {
+    edges[k] = scratch[k];
+  }
+  return num_kept;
+}
+
+template <typename VertexId, typename Weight>
+auto mst_output(std::vector<MSTEdge<VertexId, Weight>>& tree)
+{
+  std::sort(tree.begin(), tree.end());
+  std::vector<std::tuple<VertexId, VertexId, Weight>> result;
+  result.reserve(tree.size());
+  for(const auto& e : tree)
+  {
+    result.emplace_back(e.source, e.target, e.weight);
+  }
+  return result;
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Boruvka(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  using Edge = MSTEdge<VertexId, Weight>;
+  constexpr std::size_t none      = std::numeric_limits<std::size_t>::max();
+  const auto            num_nodes = graph.num_nodes();
+  auto                  edges     = mst_edges(graph);
+  std::vector<Edge>     scratch, tree;
+  std::vector<VertexId> parent(num_nodes);
+  std::vector<std::size_t> lightest(num_nodes, none);    // per component root
+  std::iota(parent.begin(), parent.end(), VertexId(0));
+
+  std::size_t size = edges.size();
+  while(size > 0)
+  {
+    // every component claims its lightest outgoing edge, parent[] is compressed
+    auto claim = [&](VertexId root, std::size_t k) {
+      auto current = atomic_load(lightest[root]);
+      while((current == none || edges[k] < edges[current]) && !compare_and_swap(lightest[root], current, k))
+      {
+        current = atomic_load(lightest[root]);
+      }
+    };
+#pragma omp parallel for
+    for(std::size_t k = 0; k < size; k++)
+    {
+      claim(parent[edges[k].source], k);
+      claim(parent[edges[k].target], k);
+    }
+    // the claimed edges link the trees; an edge claimed from both sides only
+    // links once
+#pragma omp parallel
+    {
+      std::vector<Edge> local_tree;
+#pragma omp for schedule(dynamic, 16384) nowait
+      for(std::size_t root = 0; root < num_nodes; root++)
+      {
+        const auto k = lightest[root];
+        if(k != none)
+        {
+          lightest[root] = none;
+          if(union_find_link(edges[k].source, edges[k].target, parent.data()))
+          {
+            local_tree.push_back(edges[k]);
+          }
+        }
+      }
+#pragma omp critical
+      tree.insert(tree.end(), local_tree.begin(), local_tree.end());
+    }
+    union_find_compress(num_nodes, parent.data());
+    size = mst_split(edges.data(), size, scratch, false,
+                     [&](const Edge& e) { return parent[e.source] != parent[e.target]; });
+  }
+  return mst_output(tree);
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto FilterKruskal(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  using Edge = MSTEdge<VertexId, Weight>;
+  const auto            num_nodes = graph.num_nodes();
+  auto                  edges     = mst_edges(graph);
+  std::vector<Edge>     scratch, tree;
+  std::vector<VertexId> parent(num_nodes);
+  std::iota(parent.begin(), parent.end(), VertexId(0));
+  SplitMix64 rng(num_nodes, edges.size());
+  // below this many edges a range is sorted and scanned directly
+  const std::size_t base_size = std::max<std::size_t>(1 << 14, num_nodes / 4);
+
+  // sequential find with path halving, for the Kruskal scans
+  auto find = [&parent](VertexId v) {
+    while(parent[v] != parent[parent[v]])
+    {
+      parent[v] = parent[parent[v]];
+      v         = parent[v];
+    }
+    return parent[v];
+  };
+  auto kruskal = [&](Edge* first, std::size_t size) {
+    std::sort(first, first + size);
+    for(std::size_t k = 0; k < size; k++)
+    {
+      const auto root_source = find(first[k].source);
+      const auto root_target = find(first[k].target);
+      if(root_source != root_target)
+      {
+        // the larger root goes under the smaller one, as in union_find.hpp
+        parent[std::max(root_source, root_target)] = std::min(root_source, root_target);
+        tree.push_back(first[k]);
+      }
+    }
+  };
+  // edges[first, first + size) in increasing order
+  auto filter_kruskal = [&](auto& self, Edge* first, std::size_t size) -> void {
+    if(size <= base_size)
+    {
+      kruskal(first, size);
+      return;
+    }
+    // the pivot is the median of a random sample
+    std::vector<Edge> sample(std::min<std::size_t>(size, 255));
+    for(auto& e : sample)
+    {
+      e = first[rng.next_below(size)];
+    }
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    const Edge  pivot = sample[sample.size() / 2];
+    std::size_t light = mst_split(first, size, scratch, true, [&](const Edge& e) { return e < pivot; });
+    if(light == 0)
+    {
+      // the pivot is the lightest edge, so split off the ones equal to it
+      light = mst_split(first, size, scratch, true, [&](const Edge& e) { return !(pivot < e); });
+    }
+    if(light == size)
+    {
+      kruskal(first, size);
+      return;
+    }
+    self(self, first, light);
+    if(tree.size() + 1 >= num_nodes)
+    {
+      return;    // spanning tree complete
+    }
+    union_find_compress(num_nodes, parent.data());
+    const std::size_t heavy = mst_split(first + light, size - light, scratch, false,
+                                        [&](const Edge& e) { return parent[e.source] != parent[e.target]; });
+    self(self, first + light, heavy);
+  };
+  filter_kruskal(filter_kruskal, edges.data(), edges.size());
+  return mst_output(tree);
+}
+
+int main(int argc, char** argv)
 {
   std::vector<int>   row_pointer  = { 0, 3, 5, 7, 10, 12, 14 };
   std::vector<int>   column_index = { 1, 2, 3, 0, 2, 0, 1, 0, 4, 5, 3, 5, 3, 4 };
   std::vector<float> values       = { 1.2, 3.4, 0.5, 1.2, 4.1, 3.4, 4.1, 0.5, 2.8, 1.9, 2.8, 4.7, 1.9, 4.7};
+  CSRGraph<int, int, float> graph(row_pointer, column_index, values);
+  // or load a binary CSR file written by write_csr()
+  if(argc > 1)
+  {
+    graph = load_csr<int, int, float>(argv[1]);
+  }
 
-  auto parent = Prim(row_pointer, column_index, values);
+  auto parent = Prim(graph);
   for(size_t i = 0; i < parent.size(); i++)
   {
     std::cout << parent[i] << " ";
   }
   std::cout << std::endl;
 
-  auto mst = Kruskal(row_pointer, column_index, values);
+  auto mst = Kruskal(graph);
   for (const auto& [u, v, w] : mst) {
     std::cout << u << " - " << v << " (Weight: " << w << ") , ";
   }
   std::cout << std::endl;
 
+  for(const auto& tree : { Boruvka(graph), FilterKruskal(graph) })
+  {
+    for(const auto& [u, v, w] : tree)
+    {
+      std::cout << u << " - " << v << " (Weight: " << w << ") , ";
+    }
+    std::cout << std::endl;
+  }
+
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+Shared-memory parallel helpers for the kernels.
+
+Parallel loops are plain OpenMP pragmas; compiled without -fopenmp they are
+ignored and everything runs on one thread. The atomics below use the GCC/Clang
+__atomic builtins directly on ordinary arrays, so a kernel can keep its data in
+std::vector<T> and only pay for atomicity where it actually races.
+ */
+
+inline int num_threads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline int thread_id() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+template <typename T>
+T atomic_load(const T &x) {
+    T value;
+    __atomic_load(&x, &value, __ATOMIC_ACQUIRE);
+    return value;
+}
+
+template <typename T>
+void atomic_store(T &x, T value) {
+    __atomic_store(&x, &value, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+bool compare_and_swap(T &x, T old_value, T new_value) {
+    return __atomic_compare_exchange(&x, &old_value, &new_value, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+T fetch_and_add(T &x, T inc) {
+    return __atomic_fetch_add(&x, inc, __ATOMIC_RELAXED);
+}
+
+// x = min(x, value), returns true if this call lowered x
+template <typename T>
+bool write_min(T &x, T value) {
+    T current = atomic_load(x);
+    while (value < current) {
+        if (__atomic_compare_exchange(&x, &current, &value, false,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Exclusive prefix sum: returns n + 1 entries, the last one is the total.
+// Each thread scans one block, the block totals are scanned serially and
+// added back in a second parallel pass.
+template <typename Out, typename In>
+std::vector<Out> prefix_sum(const std::vector<In> &counts) {
+    const std::size_t n = counts.size();
+    std::vector<Out> sums(n + 1);
+    const std::size_t num_blocks = std::max<std::size_t>(
+        1, std::min<std::size_t>(num_threads(), n / 4096));
+    const std::size_t block_size = (n + num_blocks - 1) / num_blocks;
+    std::vector<Out> block_sums(num_blocks + 1, 0);
+
+#pragma omp parallel for
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        const std::size_t end = std::min(n, (b + 1) * block_size);
+        Out total = 0;
+        for (std::size_t i = b * block_size; i < end; i++) {
+            total += counts[i];
+        }
+        block_sums[b + 1] = total;
+    }
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        block_sums[b + 1] += block_sums[b];
+    }
+#pragma omp parallel for
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        const std::size_t end = std::min(n, (b + 1) * block_size);
+        Out running = block_sums[b];
+        for (std::size_t i = b * block_size; i < end; i++) {
+            sums[i] = running;
+            running += counts[i];
+        }
+    }
+    sums[n] = block_sums[num_blocks];
+    return sums;
+}
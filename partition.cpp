@@ -0,0 +1,780 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "matching.hpp"
+#include "parallel.hpp"
+#include "priority_queues.hpp"
+#include "rng.hpp"
+
+/*
+ * Multilevel k-way graph partitioning
+ *
+ * Splits the vertices into num_parts parts of about equal weight while
+ * cutting as little edge weight as possible, e.g. to lay out vertices for
+ * cache / NUMA locality (see partition_order()) or to split work across
+ * processes. Three stages, as in METIS:
+ *  1. Coarsening: a heavy-edge parallel_maximal_matching() (matching.hpp,
+ *     which orders edges by weight bucket, not exact weight, so weighted
+ *     inputs such as a path with increasing weights stay near-linear)
+ *     pairs up vertices, then the ones it left unmatched are paired if they
+ *     share their first neighbor (two-hop matching, for star leaves and
+ *     isolated vertices). Each pair is contracted into one vertex carrying
+ *     their summed weight, parallel edges between contracted vertices are
+ *     merged with summed weights. Repeated until the graph is down to
+ *     coarsest_size vertices or stops shrinking. Pairs heavier than
+ *     1.5 * total / coarsest_size are not contracted, so no coarse vertex
+ *     gets too heavy to balance.
+ *  2. Initial partition of the coarsest graph by greedy graph growing,
+ *     best gain first, refined as below. Repeated initial_tries times from
+ *     different random vertices, the smallest cut among the balanced
+ *     results is kept.
+ *  3. Uncoarsening: the partition is projected back level by level. Each
+ *     level is refined by size-constrained parallel label propagation
+ *     (every vertex moves to the part it has the most edge weight to, if
+ *     that part has room; part weights are kept with fetch_and_add),
+ *     followed, on levels of at most fm_max_size vertices, by fm_passes of
+ *     sequential k-way Fiduccia-Mattheyses, which can make the swaps
+ *     through a full part that label propagation can't. The larger levels
+ *     near the input are refined by label propagation alone.
+ *     A rebalancing pass first empties any part over the limit.
+ *
+ * Label propagation moves are decided concurrently, so with more than one
+ * thread the result depends on the thread timing. Edge weights are taken
+ * as integers, unweighted edges count 1. Matching-based coarsening works
+ * best on mesh-like graphs; on power-law graphs contracting hubs with their
+ * neighbors costs quality.
+ *
+ * require:
+ * Undirected Graph without self loops
+ */
+
+struct PartitionOptions {
+    int num_parts = 2;
+    double imbalance = 0.03;       // part weight <= (1 + imbalance) * total / k
+    std::size_t coarsest_size = 0;  // 0: 40 vertices per part, at least 200
+    int initial_tries = 8;
+    int refine_rounds = 10;  // label propagation rounds per level
+    int fm_passes = 1;       // sequential FM passes per level after those
+    std::size_t fm_max_size = 1 << 16;  // levels larger than this skip FM
+    uint64_t seed = 0;
+};
+
+struct Partition {
+    std::vector<int> part;  // part of each vertex
+    std::vector<int64_t> part_weight;
+    int64_t edge_cut = 0;
+    int levels = 0;  // graphs in the hierarchy, including the input
+};
+
+template <typename Graph>
+int64_t partition_edge_weight(const Graph &graph, std::size_t i) {
+    if constexpr (Graph::is_weighted) {
+        return static_cast<int64_t>(graph.values()[i]);
+    } else {
+        (void)graph, (void)i;
+        return 1;
+    }
+}
+
+// Total weight of the edges between different parts
+template <typename VertexId, typename EdgeOffset, typename Weight>
+int64_t edge_cut(const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+                 const std::vector<int> &part) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    int64_t cut = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+ : cut)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            if (part[col_idx[i]] != part[v]) {
+                cut += partition_edge_weight(graph, i);
+            }
+        }
+    }
+    return cut / 2;  // every edge is stored at both ends
+}
+
+// New vertex ids that number the vertices part by part, keeping the id
+// order within a part
+template <typename VertexId>
+std::vector<VertexId> partition_order(const std::vector<int> &part,
+                                      int num_parts) {
+    std::vector<VertexId> next(num_parts + 1, 0);
+    for (const int p : part) {
+        next[p + 1]++;
+    }
+    for (int p = 0; p < num_parts; p++) {
+        next[p + 1] += next[p];
+    }
+    std::vector<VertexId> new_id(part.size());
+    for (std::size_t v = 0; v < part.size(); v++) {
+        new_id[v] = next[part[v]]++;
+    }
+    return new_id;
+}
+
+template <typename VertexId, typename EdgeOffset>
+struct CoarseLevel {
+    CSRGraph<VertexId, EdgeOffset, int64_t> graph;
+    std::vector<int64_t> vertex_weight;
+    std::vector<VertexId> map;  // finer vertex -> coarse vertex
+};
+
+// Contracts a heavy-edge matching of graph; the coarse vertices are numbered
+// in the order of their smaller member
+template <typename VertexId, typename EdgeOffset, typename Weight>
+CoarseLevel<VertexId, EdgeOffset> coarsen(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    const std::vector<int64_t> &vertex_weight, int64_t max_vertex_weight,
+    uint64_t seed) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+
+    std::vector<VertexId> mate(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        mate[v] = v;
+    }
+    const auto matching = parallel_maximal_matching(
+        graph, {MatchingMode::DeterministicReservations, true, seed});
+#pragma omp parallel for
+    for (std::size_t i = 0; i < matching.size(); i++) {
+        const auto [u, v] = matching[i];
+        if (vertex_weight[u] + vertex_weight[v] <= max_vertex_weight) {
+            mate[u] = v;
+            mate[v] = u;
+        }
+    }
+
+    // >> Two-hop matching
+    // Vertices the matching left alone, mostly star leaves and isolated
+    // vertices, are paired among those that share their first neighbor (or
+    // have none)
+    std::vector<std::pair<VertexId, VertexId>> unmatched;  // (neighbor, v)
+#pragma omp parallel
+    {
+        std::vector<std::pair<VertexId, VertexId>> local;
+#pragma omp for schedule(dynamic, 1024) nowait
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            if (static_cast<std::size_t>(mate[v]) == v) {
+                local.emplace_back(row_ptr[v] < row_ptr[v + 1]
+                                       ? col_idx[row_ptr[v]]
+                                       : graph.invalid_vertex,
+                                   v);
+            }
+        }
+#pragma omp critical
+        unmatched.insert(unmatched.end(), local.begin(), local.end());
+    }
+    std::sort(unmatched.begin(), unmatched.end());
+    for (std::size_t i = 0; i + 1 < unmatched.size(); i++) {
+        const auto [anchor, u] = unmatched[i];
+        const auto [next_anchor, v] = unmatched[i + 1];
+        if (anchor == next_anchor &&
+            vertex_weight[u] + vertex_weight[v] <= max_vertex_weight) {
+            mate[u] = v;
+            mate[v] = u;
+            i++;
+        }
+    }
+    std::vector<std::pair<VertexId, VertexId>>().swap(unmatched);
+
+    // >> Coarse ids
+    std::vector<VertexId> is_first(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        is_first[v] = v <= static_cast<std::size_t>(mate[v]);
+    }
+    const auto coarse_id = prefix_sum<VertexId>(is_first);
+    std::vector<VertexId>().swap(is_first);
+    const std::size_t num_coarse = coarse_id[num_nodes];
+
+    CoarseLevel<VertexId, EdgeOffset> level;
+    level.map.resize(num_nodes);
+    level.vertex_weight.resize(num_coarse);
+    std::vector<VertexId> first(num_coarse);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        const auto c = coarse_id[std::min<std::size_t>(v, mate[v])];
+        level.map[v] = c;
+        if (v <= static_cast<std::size_t>(mate[v])) {
+            first[c] = v;
+            level.vertex_weight[c] = vertex_weight[v] +
+                                     (static_cast<std::size_t>(mate[v]) != v
+                                          ? vertex_weight[mate[v]]
+                                          : 0);
+        }
+    }
+
+    // >> Contracted adjacency
+    // Blocks of coarse vertices write their merged lists to their own
+    // buffer, which is copied into place once the offsets are known.
+    const std::size_t block_size =
+        std::max<std::size_t>(1024, num_coarse / (64 * num_threads()) + 1);
+    const std::size_t num_blocks = (num_coarse + block_size - 1) / block_size;
+    std::vector<std::vector<std::pair<VertexId, int64_t>>> buffers(num_blocks);
+    std::vector<EdgeOffset> degree(num_coarse);
+#pragma omp parallel
+    {
+        std::vector<std::pair<VertexId, int64_t>> edges;
+#pragma omp for schedule(dynamic, 1)
+        for (std::size_t b = 0; b < num_blocks; b++) {
+            auto &buffer = buffers[b];
+            const std::size_t end = std::min(num_coarse, (b + 1) * block_size);
+            for (std::size_t c = b * block_size; c < end; c++) {
+                edges.clear();
+                const VertexId u = first[c];
+                for (const VertexId member : {u, mate[u]}) {
+                    for (auto i = row_ptr[member]; i < row_ptr[member + 1];
+                         i++) {
+                        const auto target = level.map[col_idx[i]];
+                        if (static_cast<std::size_t>(target) != c) {
+                            edges.emplace_back(
+                                target, partition_edge_weight(graph, i));
+                        }
+                    }
+                    if (mate[u] == u) {
+                        break;
+                    }
+                }
+                std::sort(edges.begin(), edges.end());
+                const std::size_t before = buffer.size();
+                for (const auto &[target, weight] : edges) {
+                    if (buffer.size() > before &&
+                        buffer.back().first == target) {
+                        buffer.back().second += weight;
+                    } else {
+                        buffer.emplace_back(target, weight);
+                    }
+                }
+                degree[c] = buffer.size() - before;
+            }
+        }
+    }
+    auto coarse_row_ptr = prefix_sum<EdgeOffset>(degree);
+    std::vector<EdgeOffset>().swap(degree);
+    std::vector<VertexId> coarse_col_idx(coarse_row_ptr[num_coarse]);
+    std::vector<int64_t> coarse_values(coarse_row_ptr[num_coarse]);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        auto out = coarse_row_ptr[b * block_size];
+        for (const auto &[target, weight] : buffers[b]) {
+            coarse_col_idx[out] = target;
+            coarse_values[out] = weight;
+            out++;
+        }
+        std::vector<std::pair<VertexId, int64_t>>().swap(buffers[b]);
+    }
+    level.graph = CSRGraph<VertexId, EdgeOffset, int64_t>(
+        std::move(coarse_row_ptr), std::move(coarse_col_idx),
+        std::move(coarse_values));
+    return level;
+}
+
+// Moves vertices out of parts heavier than max_part_weight, the ones that
+// add the least cut first, into the part they are best connected to among
+// those with room (the lightest part if none of their neighbors' has).
+// Best effort: with heavy vertices the limit may be out of reach.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void rebalance_partition(const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+                         const std::vector<int64_t> &vertex_weight,
+                         std::vector<int> &part,
+                         std::vector<int64_t> &part_weight,
+                         int64_t max_part_weight) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const int num_parts = part_weight.size();
+    auto overloaded = [&](int p) { return part_weight[p] > max_part_weight; };
+    if (std::none_of(part_weight.begin(), part_weight.end(),
+                     [&](int64_t w) { return w > max_part_weight; })) {
+        return;
+    }
+
+    std::vector<int64_t> connection(num_parts, 0);
+    std::vector<int> touched;
+    // Best target part with room for v and the cut it adds
+    auto best_move = [&](VertexId v) {
+        const int from = part[v];
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            const int p = part[col_idx[i]];
+            if (connection[p] == 0) {
+                touched.push_back(p);
+            }
+            connection[p] += partition_edge_weight(graph, i);
+        }
+        int best = std::min_element(part_weight.begin(), part_weight.end()) -
+                   part_weight.begin();
+        int64_t best_connection = connection[best];
+        for (const int p : touched) {
+            if (p != from && connection[p] > best_connection &&
+                part_weight[p] + vertex_weight[v] <= max_part_weight) {
+                best = p;
+                best_connection = connection[p];
+            }
+        }
+        const int64_t added = connection[from] - best_connection;
+        for (const int p : touched) {
+            connection[p] = 0;
+        }
+        touched.clear();
+        return std::make_pair(added, best);
+    };
+
+    std::vector<std::pair<int64_t, VertexId>> candidates;
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        if (overloaded(part[v])) {
+            candidates.emplace_back(best_move(v).first, v);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto &[added, v] : candidates) {
+        const int from = part[v];
+        if (!overloaded(from)) {
+            continue;
+        }
+        // the weights changed since the candidates were ranked
+        const int to = best_move(v).second;
+        if (to == from) {
+            continue;
+        }
+        part[v] = to;
+        part_weight[from] -= vertex_weight[v];
+        part_weight[to] += vertex_weight[v];
+    }
+}
+
+// Size-constrained label propagation; returns the number of moves
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::size_t refine_partition(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    const std::vector<int64_t> &vertex_weight, std::vector<int> &part,
+    std::vector<int64_t> &part_weight, int64_t max_part_weight, int rounds) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const int num_parts = part_weight.size();
+    std::size_t total_moves = 0;
+
+    for (int round = 0; round < rounds; round++) {
+        std::size_t moves = 0;
+#pragma omp parallel reduction(+ : moves)
+        {
+            std::vector<int64_t> connection(num_parts, 0);
+            std::vector<int> touched;
+#pragma omp for schedule(dynamic, 1024)
+            for (std::size_t v = 0; v < num_nodes; v++) {
+                const int from = atomic_load(part[v]);
+                for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                    const int p = atomic_load(part[col_idx[i]]);
+                    if (connection[p] == 0) {
+                        touched.push_back(p);
+                    }
+                    connection[p] += partition_edge_weight(graph, i);
+                }
+                // a better connected part, or an equally connected one that
+                // is lighter even after the move
+                const int64_t w = vertex_weight[v];
+                int best = from;
+                int64_t best_connection = connection[from];
+                int64_t best_weight = atomic_load(part_weight[from]) - w;
+                for (const int p : touched) {
+                    const int64_t weight = atomic_load(part_weight[p]);
+                    if (p == from || weight + w > max_part_weight) {
+                        continue;
+                    }
+                    if (connection[p] > best_connection ||
+                        (connection[p] == best_connection &&
+                         weight < best_weight)) {
+                        best = p;
+                        best_connection = connection[p];
+                        best_weight = weight;
+                    }
+                }
+                for (const int p : touched) {
+                    connection[p] = 0;
+                }
+                touched.clear();
+                if (best == from) {
+                    continue;
+                }
+                // another thread may have filled the part in the meantime
+                if (fetch_and_add(part_weight[best], w) + w > max_part_weight) {
+                    fetch_and_add(part_weight[best], -w);
+                    continue;
+                }
+                fetch_and_add(part_weight[from], -w);
+                atomic_store(part[v], best);
+                moves++;
+            }
+        }
+        total_moves += moves;
+        if (moves <= num_nodes / 1000) {
+            break;
+        }
+    }
+    return total_moves;
+}
+
+// Sequential k-way Fiduccia-Mattheyses, for the coarser levels: each
+// pass moves every vertex at most once, best gain first, also through
+// moves that add cut, so a full part can give up a vertex to take a better
+// one. The pass is rolled back to its best state: least overload, then
+// least cut. Targets are the adjacent parts with room and the lightest part.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void fm_refine(const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+               const std::vector<int64_t> &vertex_weight,
+               std::vector<int> &part, std::vector<int64_t> &part_weight,
+               int64_t max_part_weight, int passes) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const int num_parts = part_weight.size();
+    // a pass gives up after this many moves without a new best state
+    const std::size_t patience = std::max<std::size_t>(50, num_nodes / 20);
+    auto overload = [&] {
+        return std::max<int64_t>(
+            0, *std::max_element(part_weight.begin(), part_weight.end()) -
+                   max_part_weight);
+    };
+
+    std::vector<int64_t> connection(num_parts, 0);
+    std::vector<int> touched;
+    std::vector<int64_t> gain(num_nodes);
+    std::vector<int> target(num_nodes);
+    std::vector<bool> locked(num_nodes);
+    // Best move of v into gain[v] / target[v], -1 if it has none
+    auto update = [&](VertexId v) {
+        const int from = part[v];
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            const int p = part[col_idx[i]];
+            if (connection[p] == 0) {
+                touched.push_back(p);
+            }
+            connection[p] += partition_edge_weight(graph, i);
+        }
+        const int lightest =
+            std::min_element(part_weight.begin(), part_weight.end()) -
+            part_weight.begin();
+        int best = -1;
+        int64_t best_connection = 0;
+        auto consider = [&](int p) {
+            if (p != from &&
+                (part_weight[p] + vertex_weight[v] <= max_part_weight ||
+                 part_weight[p] + vertex_weight[v] < part_weight[from]) &&
+                (best == -1 || connection[p] > best_connection)) {
+                best = p;
+                best_connection = connection[p];
+            }
+        };
+        consider(lightest);
+        for (const int p : touched) {
+            consider(p);
+        }
+        gain[v] = best_connection - connection[from];
+        target[v] = best;
+        for (const int p : touched) {
+            connection[p] = 0;
+        }
+        touched.clear();
+    };
+
+    for (int pass = 0; pass < passes; pass++) {
+        // keyed by the negated gain, stale entries are skipped
+        BinaryHeap<VertexId, int64_t> heap(num_nodes, 0);
+        std::fill(locked.begin(), locked.end(), false);
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            update(v);
+            if (target[v] != -1) {
+                heap.push(v, -gain[v]);
+            }
+        }
+        std::vector<std::pair<VertexId, int>> moves;  // (vertex, from)
+        int64_t cut_change = 0, best_cut_change = 0;
+        int64_t best_overload = overload();
+        std::size_t best_moves = 0;
+        while (!heap.empty() && moves.size() - best_moves < patience) {
+            const auto [key, v] = heap.pop();
+            if (locked[v] || target[v] == -1 || key != -gain[v]) {
+                continue;
+            }
+            const int from = part[v], to = target[v];
+            locked[v] = true;
+            part[v] = to;
+            part_weight[from] -= vertex_weight[v];
+            part_weight[to] += vertex_weight[v];
+            cut_change -= gain[v];
+            moves.emplace_back(v, from);
+            const int64_t now_overload = overload();
+            if (now_overload < best_overload ||
+                (now_overload == best_overload &&
+                 cut_change < best_cut_change)) {
+                best_overload = now_overload;
+                best_cut_change = cut_change;
+                best_moves = moves.size();
+            }
+            for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                const VertexId u = col_idx[i];
+                if (!locked[u]) {
+                    update(u);
+                    if (target[u] != -1) {
+                        heap.push(u, -gain[u]);
+                    }
+                }
+            }
+        }
+        while (moves.size() > best_moves) {
+            const auto [v, from] = moves.back();
+            moves.pop_back();
+            part_weight[part[v]] -= vertex_weight[v];
+            part_weight[from] += vertex_weight[v];
+            part[v] = from;
+        }
+        if (best_moves == 0) {
+            break;
+        }
+    }
+}
+
+// Greedy graph growing: part p takes its share of the remaining weight from
+// a random vertex, always adding the frontier vertex whose move cuts the
+// least (edge weight into the part minus edge weight out), and jumping to
+// another random vertex when the frontier runs dry; the last part takes the
+// rest. Isolated vertices cut nothing anywhere, they are left out of the
+// growing and fill up the lightest parts.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<int> grow_partition(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    const std::vector<int64_t> &vertex_weight, int num_parts,
+    SplitMix64 &rng) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    std::vector<int> part(num_nodes, -1);
+    std::vector<int64_t> part_weight(num_parts, 0);
+    std::vector<int64_t> degree_weight(num_nodes, 0);
+    int64_t remaining = 0;
+    std::size_t unassigned = 0;  // vertices with neighbors
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+            degree_weight[v] += partition_edge_weight(graph, i);
+        }
+        remaining += vertex_weight[v];
+        unassigned += graph.degree(v) > 0;
+    }
+
+    // edge weight of each frontier vertex into the growing part
+    std::vector<int64_t> connection(num_nodes, 0);
+    std::vector<VertexId> frontier;
+    for (int p = 0; p + 1 < num_parts && unassigned > 0; p++) {
+        const int64_t target = remaining / (num_parts - p);
+        // keyed by the negated gain, stale entries are skipped
+        BinaryHeap<VertexId, int64_t> heap(num_nodes, 0);
+        auto gain = [&](VertexId v) {
+            return 2 * connection[v] - degree_weight[v];
+        };
+        while (part_weight[p] < target && unassigned > 0) {
+            if (heap.empty()) {
+                std::size_t seed = rng.next_below(num_nodes);
+                while (part[seed] != -1 || graph.degree(seed) == 0) {
+                    seed = seed + 1 == num_nodes ? 0 : seed + 1;
+                }
+                heap.push(seed, -gain(seed));
+            }
+            const auto [key, v] = heap.pop();
+            if (part[v] != -1 || key != -gain(v)) {
+                continue;
+            }
+            part[v] = p;
+            part_weight[p] += vertex_weight[v];
+            unassigned--;
+            for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                const VertexId u = col_idx[i];
+                if (part[u] == -1) {
+                    if (connection[u] == 0) {
+                        frontier.push_back(u);
+                    }
+                    connection[u] += partition_edge_weight(graph, i);
+                    heap.push(u, -gain(u));
+                }
+            }
+        }
+        remaining -= part_weight[p];
+        for (const VertexId u : frontier) {
+            connection[u] = 0;
+        }
+        frontier.clear();
+    }
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        if (part[v] == -1 && graph.degree(v) > 0) {
+            part[v] = num_parts - 1;
+            part_weight[num_parts - 1] += vertex_weight[v];
+        }
+    }
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        if (part[v] == -1) {
+            part[v] = std::min_element(part_weight.begin(), part_weight.end()) -
+                      part_weight.begin();
+            part_weight[part[v]] += vertex_weight[v];
+        }
+    }
+    return part;
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+Partition multilevel_partition(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+    PartitionOptions options = {}) {
+    const auto num_nodes = graph.num_nodes();
+    const int num_parts = std::max(1, options.num_parts);
+    const std::size_t coarsest_size =
+        options.coarsest_size > 0
+            ? options.coarsest_size
+            : std::max<std::size_t>(200, 40 * std::size_t(num_parts));
+    const int64_t total_weight = num_nodes;
+    const int64_t max_part_weight = std::max<int64_t>(
+        std::ceil((1 + options.imbalance) * total_weight / num_parts),
+        (total_weight + num_parts - 1) / num_parts);
+    const int64_t max_vertex_weight = std::max<int64_t>(
+        2, 1.5 * total_weight / std::max<std::size_t>(coarsest_size, 1));
+
+    // >> Coarsening; levels[i] is graph level i + 1, the input is level 0
+    std::vector<CoarseLevel<VertexId, EdgeOffset>> levels;
+    const std::vector<int64_t> unit_weight(num_nodes, 1);
+    auto with_level = [&](std::size_t i, auto f) {
+        return i == 0 ? f(graph, unit_weight)
+                      : f(levels[i - 1].graph, levels[i - 1].vertex_weight);
+    };
+    while (true) {
+        const std::size_t n =
+            levels.empty() ? num_nodes : levels.back().graph.num_nodes();
+        if (n <= coarsest_size) {
+            break;
+        }
+        auto level = with_level(levels.size(), [&](const auto &g,
+                                                   const auto &weight) {
+            return coarsen(g, weight, max_vertex_weight,
+                           options.seed + levels.size());
+        });
+        // a level that barely shrinks the graph is not worth its refinement
+        if (level.graph.num_nodes() > 0.95 * n) {
+            break;
+        }
+        levels.push_back(std::move(level));
+    }
+
+    // >> Initial partition of the coarsest graph
+    auto refine = [&](std::size_t i, std::vector<int> &part,
+                      std::vector<int64_t> &part_weight) {
+        with_level(i, [&](const auto &g, const auto &weight) {
+            rebalance_partition(g, weight, part, part_weight, max_part_weight);
+            refine_partition(g, weight, part, part_weight, max_part_weight,
+                             options.refine_rounds);
+            if (g.num_nodes() <= options.fm_max_size) {
+                fm_refine(g, weight, part, part_weight, max_part_weight,
+                          options.fm_passes);
+            }
+            return 0;
+        });
+    };
+    auto weigh = [&](std::size_t i, const std::vector<int> &part) {
+        std::vector<int64_t> part_weight(num_parts, 0);
+        with_level(i, [&](const auto &, const auto &weight) {
+            for (std::size_t v = 0; v < part.size(); v++) {
+                part_weight[part[v]] += weight[v];
+            }
+            return 0;
+        });
+        return part_weight;
+    };
+    auto cut_of = [&](std::size_t i, const std::vector<int> &part) {
+        return with_level(
+            i, [&](const auto &g, const auto &) { return edge_cut(g, part); });
+    };
+
+    const std::size_t coarsest = levels.size();
+    Partition result;
+    bool best_balanced = false;
+    SplitMix64 rng(options.seed, coarsest);
+    for (int attempt = 0; attempt < std::max(1, options.initial_tries);
+         attempt++) {
+        auto part = with_level(coarsest, [&](const auto &g, const auto &weight) {
+            return grow_partition(g, weight, num_parts, rng);
+        });
+        auto part_weight = weigh(coarsest, part);
+        refine(coarsest, part, part_weight);
+        const int64_t cut = cut_of(coarsest, part);
+        const bool balanced =
+            *std::max_element(part_weight.begin(), part_weight.end()) <=
+            max_part_weight;
+        if (attempt == 0 || (balanced && !best_balanced) ||
+            (balanced == best_balanced && cut < result.edge_cut)) {
+            result.part = std::move(part);
+            result.part_weight = std::move(part_weight);
+            result.edge_cut = cut;
+            best_balanced = balanced;
+        }
+    }
+
+    // >> Uncoarsening
+    for (std::size_t i = coarsest; i-- > 0;) {
+        const auto &map = levels[i].map;
+        std::vector<int> part(map.size());
+#pragma omp parallel for
+        for (std::size_t v = 0; v < map.size(); v++) {
+            part[v] = result.part[map[v]];
+        }
+        result.part = std::move(part);
+        refine(i, result.part, result.part_weight);
+    }
+    result.edge_cut = edge_cut(graph, result.part);
+    result.levels = coarsest + 1;
+    return result;
+}
+
+int main(int argc, char **argv) {
+    /* Graph: two 4-cliques joined by the edge 3 -- 4
+    0 -- 1   5 -- 6
+    | \/ |   | \/ |
+    | /\ |   | /\ |
+    2 -- 3 - 4 -- 7
+    */
+    std::vector<int> rowPtr = {0, 3, 6, 9, 13, 17, 20, 23, 26};
+    std::vector<int> colIndex = {1, 2, 3, 0, 2, 3, 0, 1, 3, 0, 1, 2, 4,
+                                 3, 5, 6, 7, 4, 6, 7, 4, 5, 7, 4, 5, 6};
+
+    CSRGraph<> graph(rowPtr, colIndex);
+    PartitionOptions options;
+    // or load a binary CSR file written by write_csr(), and a part count
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
+    if (argc > 2) {
+        options.num_parts = std::stoi(argv[2]);
+    }
+
+    const Partition partition = multilevel_partition(graph, options);
+
+    if (argc <= 1) {
+        for (size_t i = 0; i < partition.part.size(); ++i) {
+            std::cout << "Vertex " << i << " ---> Part " << partition.part[i]
+                      << std::endl;
+        }
+    }
+    std::cout << options.num_parts << " parts, " << partition.levels
+              << " levels, edge cut " << partition.edge_cut << std::endl;
+    for (int p = 0; p < options.num_parts; p++) {
+        std::cout << "part " << p << ": " << partition.part_weight[p]
+                  << " vertices" << std::endl;
+    }
+    return 0;
+}
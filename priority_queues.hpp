@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Min-priority queues over (key, vertex) for Dijkstra and Prim.
+
+All of them share one interface so the kernels can take the queue as a
+template parameter:
+
+    Queue(num_nodes, max_weight)  max_weight is only read if needs_max_weight
+    empty()
+    push(vertex, key)             insert, or lower the key of a queued vertex
+    pop() -> {key, vertex}        remove the minimum
+
+    BinaryHeap       std::priority_queue with lazy deletion: push() always adds
+                     an entry, so pop() may return stale ones
+    IndexedDaryHeap  d-ary heap with a position index, push() is a real
+                     decrease-key, so no vertex is ever queued twice
+    RadixHeap        integer keys, monotone (no push below the last pop):
+                     O(log C) amortized per vertex instead of O(log V)
+    DialBuckets      integer keys, monotone, a ring of max_weight + 1 buckets,
+                     O(1) per operation for small integer weights
+
+Monotone queues only fit Dijkstra; Prim's keys are edge weights and can go
+below the last popped key.
+ */
+
+template <typename VertexId, typename Weight>
+class BinaryHeap {
+   public:
+    static constexpr bool monotone = false;
+    static constexpr bool needs_max_weight = false;
+
+    BinaryHeap(std::size_t, Weight) {}
+
+    bool empty() const { return heap_.empty(); }
+    void push(VertexId v, Weight key) { heap_.emplace(key, v); }
+    std::pair<Weight, VertexId> pop() {
+        auto top = heap_.top();
+        heap_.pop();
+        return top;
+    }
+
+   private:
+    std::priority_queue<std::pair<Weight, VertexId>,
+                        std::vector<std::pair<Weight, VertexId>>,
+                        std::greater<std::pair<Weight, VertexId>>>
+        heap_;
+};
+
+template <typename VertexId, typename Weight, int Arity = 4>
+class IndexedDaryHeap {
+    static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+   public:
+    static constexpr bool monotone = false;
+    static constexpr bool needs_max_weight = false;
+
+    IndexedDaryHeap(std::size_t num_nodes, Weight)
+        : position_(num_nodes, npos), key_(num_nodes) {}
+
+    bool empty() const { return heap_.empty(); }
+
+    void push(VertexId v, Weight key) {
+        if (position_[v] == npos) {
+            position_[v] = heap_.size();
+            heap_.push_back(v);
+        } else if (!(key < key_[v])) {
+            return;
+        }
+        key_[v] = key;
+        sift_up(position_[v]);
+    }
+
+    std::pair<Weight, VertexId> pop() {
+        const auto top = heap_.front();
+        position_[top] = npos;
+        const auto last = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty()) {
+            heap_[0] = last;
+            position_[last] = 0;
+            sift_down(0);
+        }
+        return {key_[top], top};
+    }
+
+   private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    void place(std::size_t i, VertexId v) {
+        heap_[i] = v;
+        position_[v] = i;
+    }
+
+    void sift_up(std::size_t i) {
+        const auto v = heap_[i];
+        while (i > 0) {
+            const auto parent = (i - 1) / Arity;
+            if (!(key_[v] < key_[heap_[parent]])) {
+                break;
+            }
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, v);
+    }
+
+    void sift_down(std::size_t i) {
+        const auto v = heap_[i];
+        const auto size = heap_.size();
+        while (true) {
+            const auto first = i * Arity + 1;
+            if (first >= size) {
+                break;
+            }
+            auto best = first;
+            const auto last = std::min(first + Arity, size);
+            for (auto c = first + 1; c < last; c++) {
+                if (key_[heap_[c]] < key_[heap_[best]]) {
+                    best = c;
+                }
+            }
+            if (!(key_[heap_[best]] < key_[v])) {
+                break;
+            }
+            place(i, heap_[best]);
+            i = best;
+        }
+        place(i, v);
+    }
+
+    std::vector<VertexId> heap_;
+    std::vector<std::size_t> position_;  // npos if not queued
+    std::vector<Weight> key_;
+};
+
+template <typename VertexId, typename Weight>
+class RadixHeap {
+    static_assert(std::is_integral_v<Weight>, "RadixHeap needs integer keys");
+    using Key = std::make_unsigned_t<Weight>;
+    static constexpr int num_buckets = std::numeric_limits<Key>::digits + 1;
+
+   public:
+    static constexpr bool monotone = true;
+    static constexpr bool needs_max_weight = false;
+
+    RadixHeap(std::size_t, Weight) {}
+
+    bool empty() const { return size_ == 0; }
+
+    void push(VertexId v, Weight key) {
+        buckets_[bucket_of(key)].emplace_back(static_cast<Key>(key), v);
+        size_++;
+    }
+
+    std::pair<Weight, VertexId> pop() {
+        if (buckets_[0].empty()) {
+            // redistribute the first non-empty bucket around its minimum;
+            // every entry then lands in a strictly lower bucket
+            int i = 1;
+            while (buckets_[i].empty()) {
+                i++;
+            }
+            Key minimum = std::numeric_limits<Key>::max();
+            for (const auto &entry : buckets_[i]) {
+                minimum = std::min(minimum, entry.first);
+            }
+            last_ = minimum;
+            for (const auto &entry : buckets_[i]) {
+                buckets_[bucket_of(entry.first)].push_back(entry);
+            }
+            buckets_[i].clear();
+        }
+        const auto entry = buckets_[0].back();
+        buckets_[0].pop_back();
+        size_--;
+        return {static_cast<Weight>(entry.first), entry.second};
+    }
+
+   private:
+    // index of the highest bit in which key differs from the last minimum
+    int bucket_of(Key key) const {
+        const auto diff = static_cast<uint64_t>(key ^ last_);
+        return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+    }
+
+    std::vector<std::pair<Key, VertexId>> buckets_[num_buckets];
+    Key last_ = 0;
+    std::size_t size_ = 0;
+};
+
+template <typename VertexId, typename Weight>
+class DialBuckets {
+    static_assert(std::is_integral_v<Weight>, "DialBuckets needs integer keys");
+
+   public:
+    static constexpr bool monotone = true;
+    static constexpr bool needs_max_weight = true;
+
+    // queued keys always lie within [current, current + max_weight]
+    DialBuckets(std::size_t, Weight max_weight)
+        : buckets_(static_cast<std::size_t>(max_weight) + 1) {}
+
+    bool empty() const { return size_ == 0; }
+
+    void push(VertexId v, Weight key) {
+        buckets_[static_cast<std::size_t>(key) % buckets_.size()].push_back(v);
+        size_++;
+    }
+
+    std::pair<Weight, VertexId> pop() {
+        while (buckets_[current_ % buckets_.size()].empty()) {
+            current_++;
+        }
+        auto &bucket = buckets_[current_ % buckets_.size()];
+        const auto v = bucket.back();
+        bucket.pop_back();
+        size_--;
+        return {static_cast<Weight>(current_), v};
+    }
+
+   private:
+    std::vector<std::vector<VertexId>> buckets_;
+    std::size_t current_ = 0;
+    std::size_t size_ = 0;
+};
+
+// What Dijkstra uses unless told otherwise
+template <typename VertexId, typename Weight>
+using MonotoneQueue =
+    std::conditional_t<std::is_integral_v<Weight>, RadixHeap<VertexId, Weight>,
+                       IndexedDaryHeap<VertexId, Weight>>;
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+/*
+Parallel radix sort of (key, payload) pairs held in two separate arrays
+(structure of arrays), e.g. edge weights with edge ids for Kruskal, or
+source ids with target ids when building a CSR.
+
+    radix_sort_stable(keys, payload, size)   LSD, stable
+    radix_sort(keys, payload, size)          MSD, not stable
+
+Both take 8-bit digits and count all digits of every key in one pass up
+front, so digits on which all keys agree (e.g. the high bytes of small ids)
+cost nothing. Each scatter pass then counts its digit on one block of
+consecutive entries per thread and writes every block to its own offsets,
+the layout transpose.hpp uses, which is what keeps the LSD variant stable.
+ - radix_sort_stable scatters the whole array once per remaining digit,
+   ping-ponging with a scratch copy.
+ - radix_sort scatters once in parallel on the highest remaining digit, then
+   sorts the 256 buckets independently and in place (American flag sort,
+   insertion sort below 64 entries), which stays in cache and stops as soon
+   as a bucket is sorted. A bucket holding most of the keys is sorted by a
+   single thread, so on heavily skewed keys prefer the stable variant.
+
+Keys are any integer or floating-point type and are compared through an
+order-preserving unsigned image (radix_order): signed integers get their
+sign bit flipped, floats additionally get their other bits inverted when
+negative, so -0.0 sorts before +0.0 and NaNs go to the ends by sign. The
+payload can be any trivially copyable type, or be left out.
+ */
+
+// Unsigned integer whose order matches the order of the keys
+template <typename Key>
+auto radix_order(Key key) {
+    static_assert(std::is_arithmetic_v<Key>, "radix keys must be numbers");
+    using Bits = std::conditional_t<
+        sizeof(Key) == 1, uint8_t,
+        std::conditional_t<
+            sizeof(Key) == 2, uint16_t,
+            std::conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>>>;
+    static_assert(sizeof(Bits) == sizeof(Key), "unsupported key width");
+    constexpr Bits sign = Bits(1) << (8 * sizeof(Key) - 1);
+    Bits bits;
+    std::memcpy(&bits, &key, sizeof(Key));
+    if constexpr (std::is_floating_point_v<Key>) {
+        return static_cast<Bits>(bits & sign ? ~bits : bits | sign);
+    } else if constexpr (std::is_signed_v<Key>) {
+        return static_cast<Bits>(bits ^ sign);
+    } else {
+        return bits;
+    }
+}
+
+namespace radix_detail {
+
+constexpr int digit_bits = 8;
+constexpr std::size_t radix = std::size_t(1) << digit_bits;
+// below this many entries the sorts run on one thread
+constexpr std::size_t parallel_size = std::size_t(1) << 16;
+constexpr std::size_t insertion_size = 64;
+
+template <typename Key>
+constexpr int num_digits = sizeof(Key) * 8 / digit_bits;
+
+template <typename Key>
+std::size_t digit(Key key, int d) {
+    return (radix_order(key) >> (d * digit_bits)) & (radix - 1);
+}
+
+// count[d * radix + x]: keys whose digit d is x, for all digits at once
+template <typename Key>
+std::vector<std::size_t> count_digits(const Key *keys, std::size_t size,
+                                      std::size_t num_blocks) {
+    (void)num_blocks;  // only read by OpenMP
+    constexpr int digits = num_digits<Key>;
+    std::vector<std::size_t> count(digits * radix, 0);
+#pragma omp parallel if (num_blocks > 1)
+    {
+        std::vector<std::size_t> local(digits * radix, 0);
+#pragma omp for nowait
+        for (std::size_t i = 0; i < size; i++) {
+            const auto order = radix_order(keys[i]);
+            for (int d = 0; d < digits; d++) {
+                local[d * radix +
+                      ((order >> (d * digit_bits)) & (radix - 1))]++;
+            }
+        }
+#pragma omp critical
+        for (std::size_t x = 0; x < local.size(); x++) {
+            count[x] += local[x];
+        }
+    }
+    return count;
+}
+
+// True if every key has the same digit d
+inline bool constant_digit(const std::vector<std::size_t> &count, int d,
+                           std::size_t size) {
+    for (std::size_t x = 0; x < radix; x++) {
+        if (count[d * radix + x] != 0) {
+            return count[d * radix + x] == size;
+        }
+    }
+    return true;
+}
+
+// Stable scatter of [0, size) by digit d from (keys, payload) to (out_keys,
+// out_payload); bucket_start gets the radix + 1 bucket offsets if not null.
+// Blocks are [size * b / num_blocks, size * (b + 1) / num_blocks).
+template <typename Key, typename Payload>
+void scatter(const Key *keys, const Payload *payload, Key *out_keys,
+             Payload *out_payload, std::size_t size, std::size_t num_blocks,
+             int d, std::size_t *bucket_start) {
+    // offset[b * radix + x]: first slot of block b in bucket x, so within a
+    // bucket the blocks, and the entries of each block, keep their order
+    std::vector<std::size_t> offset(num_blocks * radix, 0);
+#pragma omp parallel for if (num_blocks > 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        std::size_t *count = offset.data() + b * radix;
+        for (std::size_t i = size * b / num_blocks;
+             i < size * (b + 1) / num_blocks; i++) {
+            count[digit(keys[i], d)]++;
+        }
+    }
+    std::size_t next = 0;
+    for (std::size_t x = 0; x < radix; x++) {
+        if (bucket_start) {
+            bucket_start[x] = next;
+        }
+        for (std::size_t b = 0; b < num_blocks; b++) {
+            const std::size_t count = offset[b * radix + x];
+            offset[b * radix + x] = next;
+            next += count;
+        }
+    }
+    if (bucket_start) {
+        bucket_start[radix] = next;
+    }
+#pragma omp parallel for if (num_blocks > 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        std::size_t *slot = offset.data() + b * radix;
+        for (std::size_t i = size * b / num_blocks;
+             i < size * (b + 1) / num_blocks; i++) {
+            const std::size_t to = slot[digit(keys[i], d)]++;
+            out_keys[to] = keys[i];
+            if constexpr (!std::is_void_v<Payload>) {
+                out_payload[to] = payload[i];
+            }
+        }
+    }
+}
+
+template <typename Key, typename Payload>
+void insertion_sort(Key *keys, Payload *payload, std::size_t size) {
+    for (std::size_t i = 1; i < size; i++) {
+        const Key key = keys[i];
+        const auto order = radix_order(key);
+        std::size_t j = i;
+        if constexpr (std::is_void_v<Payload>) {
+            for (; j > 0 && order < radix_order(keys[j - 1]); j--) {
+                keys[j] = keys[j - 1];
+            }
+        } else {
+            const Payload value = payload[i];
+            for (; j > 0 && order < radix_order(keys[j - 1]); j--) {
+                keys[j] = keys[j - 1];
+                payload[j] = payload[j - 1];
+            }
+            payload[j] = value;
+        }
+        keys[j] = key;
+    }
+}
+
+// payload + i, also for a missing (void) payload
+template <typename Payload>
+Payload *offset_payload(Payload *payload, std::size_t i) {
+    if constexpr (std::is_void_v<Payload>) {
+        return payload;
+    } else {
+        return payload + i;
+    }
+}
+
+// Sequential in-place MSD sort on digits d, d - 1, ..., 0
+template <typename Key, typename Payload>
+void american_flag_sort(Key *keys, Payload *payload, std::size_t size, int d) {
+    if (size <= insertion_size) {
+        insertion_sort(keys, payload, size);
+        return;
+    }
+    std::size_t count[radix] = {};
+    for (std::size_t i = 0; i < size; i++) {
+        count[digit(keys[i], d)]++;
+    }
+    // bucket x is [head[x], end[x]); head[x] advances as it is filled
+    std::size_t head[radix], end[radix];
+    std::size_t next = 0;
+    for (std::size_t x = 0; x < radix; x++) {
+        head[x] = next;
+        next += count[x];
+        end[x] = next;
+    }
+    if (count[digit(keys[0], d)] != size) {
+        for (std::size_t x = 0; x < radix; x++) {
+            while (head[x] < end[x]) {
+                // carry the entry at head[x] along its cycle until one that
+                // belongs in bucket x comes back
+                Key key = keys[head[x]];
+                std::size_t to = digit(key, d);
+                if constexpr (std::is_void_v<Payload>) {
+                    while (to != x) {
+                        std::swap(key, keys[head[to]++]);
+                        to = digit(key, d);
+                    }
+                } else {
+                    Payload value = payload[head[x]];
+                    while (to != x) {
+                        const std::size_t slot = head[to]++;
+                        std::swap(key, keys[slot]);
+                        std::swap(value, payload[slot]);
+                        to = digit(key, d);
+                    }
+                    payload[head[x]] = value;
+                }
+                keys[head[x]++] = key;
+            }
+        }
+    }
+    if (d == 0) {
+        return;
+    }
+    std::size_t begin = 0;
+    for (std::size_t x = 0; x < radix; x++) {
+        const std::size_t bucket = count[x];
+        if (bucket > 1) {
+            american_flag_sort(keys, offset_payload(payload, begin),
+                               bucket, d - 1);
+        }
+        keys += bucket;
+        begin += bucket;
+    }
+}
+
+template <typename Key, typename Payload>
+void sort_stable(Key *keys, Payload *payload, std::size_t size) {
+    constexpr int digits = num_digits<Key>;
+    if (size <= insertion_size) {
+        insertion_sort(keys, payload, size);  // stable as well
+        return;
+    }
+    const std::size_t num_blocks =
+        size < parallel_size ? 1 : std::size_t(num_threads());
+    const auto count = count_digits(keys, size, num_blocks);
+    std::vector<Key> scratch_keys;
+    std::vector<std::conditional_t<std::is_void_v<Payload>, char, Payload>>
+        scratch_payload;
+    Key *from_keys = keys, *to_keys = nullptr;
+    Payload *from_payload = payload, *to_payload = nullptr;
+    for (int d = 0; d < digits; d++) {
+        if (constant_digit(count, d, size)) {
+            continue;
+        }
+        if (scratch_keys.empty()) {
+            scratch_keys.resize(size);
+            if constexpr (!std::is_void_v<Payload>) {
+                scratch_payload.resize(size);
+            }
+            to_keys = scratch_keys.data();
+            if constexpr (!std::is_void_v<Payload>) {
+                to_payload = scratch_payload.data();
+            }
+        }
+        scatter(from_keys, from_payload, to_keys, to_payload, size,
+                num_blocks, d, nullptr);
+        std::swap(from_keys, to_keys);
+        std::swap(from_payload, to_payload);
+    }
+    if (from_keys != keys) {
+#pragma omp parallel for if (num_blocks > 1)
+        for (std::size_t i = 0; i < size; i++) {
+            keys[i] = from_keys[i];
+            if constexpr (!std::is_void_v<Payload>) {
+                payload[i] = from_payload[i];
+            }
+        }
+    }
+}
+
+template <typename Key, typename Payload>
+void sort_unstable(Key *keys, Payload *payload, std::size_t size) {
+    constexpr int digits = num_digits<Key>;
+    if (size < parallel_size) {
+        american_flag_sort(keys, payload, size, digits - 1);
+        return;
+    }
+    const std::size_t num_blocks = num_threads();
+    const auto count = count_digits(keys, size, num_blocks);
+    int d = digits - 1;
+    while (d > 0 && constant_digit(count, d, size)) {
+        d--;
+    }
+    // one parallel pass on the top digit, into scratch and back
+    std::vector<Key> scratch_keys(size);
+    std::vector<std::conditional_t<std::is_void_v<Payload>, char, Payload>>
+        scratch_payload(std::is_void_v<Payload> ? 0 : size);
+    Payload *scratch = nullptr;
+    if constexpr (!std::is_void_v<Payload>) {
+        scratch = scratch_payload.data();
+    }
+    std::size_t bucket_start[radix + 1];
+    scatter(keys, payload, scratch_keys.data(), scratch, size, num_blocks, d,
+            bucket_start);
+#pragma omp parallel for
+    for (std::size_t i = 0; i < size; i++) {
+        keys[i] = scratch_keys[i];
+        if constexpr (!std::is_void_v<Payload>) {
+            payload[i] = scratch[i];
+        }
+    }
+    if (d == 0) {
+        return;
+    }
+    // the buckets, largest first
+    std::size_t order[radix];
+    for (std::size_t x = 0; x < radix; x++) {
+        order[x] = x;
+    }
+    std::sort(order, order + radix, [&](std::size_t a, std::size_t b) {
+        return bucket_start[a + 1] - bucket_start[a] >
+               bucket_start[b + 1] - bucket_start[b];
+    });
+#pragma omp parallel for schedule(dynamic, 1)
+    for (std::size_t k = 0; k < radix; k++) {
+        const std::size_t x = order[k];
+        const std::size_t begin = bucket_start[x];
+        const std::size_t bucket = bucket_start[x + 1] - begin;
+        if (bucket > 1) {
+            american_flag_sort(keys + begin, offset_payload(payload, begin),
+                               bucket, d - 1);
+        }
+    }
+}
+
+}  // namespace radix_detail
+
+// Sorts keys[0, size) ascending and moves payload[i] along with keys[i];
+// equal keys keep their order
+template <typename Key, typename Payload>
+void radix_sort_stable(Key *keys, Payload *payload, std::size_t size) {
+    radix_detail::sort_stable(keys, payload, size);
+}
+
+template <typename Key>
+void radix_sort_stable(Key *keys, std::size_t size) {
+    radix_detail::sort_stable(keys, static_cast<void *>(nullptr), size);
+}
+
+// Like radix_sort_stable(), but equal keys may end up in any order
+template <typename Key, typename Payload>
+void radix_sort(Key *keys, Payload *payload, std::size_t size) {
+    radix_detail::sort_unstable(keys, payload, size);
+}
+
+template <typename Key>
+void radix_sort(Key *keys, std::size_t size) {
+    radix_detail::sort_unstable(keys, static_cast<void *>(nullptr), size);
+}
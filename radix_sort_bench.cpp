@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "radix_sort.hpp"
+#include "rng.hpp"
+
+// Benchmark of radix_sort.hpp against std::sort and std::stable_sort on
+// (key, payload) pairs with a 4-byte payload, e.g. edge weights with edge
+// ids. The std sorts get the pairs as one array of structs, which is what
+// they need; the radix sorts get the same data as two arrays. Reports
+// nanoseconds per pair and checks every result against std::stable_sort.
+//
+//     radix_sort_bench [pairs] [repeats]
+
+template <typename Key>
+struct Input {
+    const char *name;
+    std::vector<Key> keys;
+};
+
+template <typename Key>
+void bench(const Input<Key> &input, int repeats) {
+    using Pair = std::pair<Key, uint32_t>;
+    const std::size_t size = input.keys.size();
+    std::vector<Pair> reference(size);
+    for (std::size_t i = 0; i < size; i++) {
+        reference[i] = {input.keys[i], uint32_t(i)};
+    }
+    auto by_key = [](const Pair &a, const Pair &b) {
+        return radix_order(a.first) < radix_order(b.first);
+    };
+    std::stable_sort(reference.begin(), reference.end(), by_key);
+
+    std::cout << std::setw(16) << input.name;
+    auto report = [&](auto run, bool stable) {
+        double best = 0;
+        for (int r = 0; r < repeats; r++) {
+            std::vector<Key> keys = input.keys;
+            std::vector<uint32_t> payload(size);
+            for (std::size_t i = 0; i < size; i++) {
+                payload[i] = i;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            run(keys, payload);
+            const std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+            best = r == 0 ? elapsed.count() : std::min(best, elapsed.count());
+            for (std::size_t i = 0; i < size; i++) {
+                // an unstable sort only has to agree on the keys, and keep
+                // every payload with its key
+                if (radix_order(keys[i]) != radix_order(reference[i].first) ||
+                    (stable && payload[i] != reference[i].second) ||
+                    radix_order(input.keys[payload[i]]) !=
+                        radix_order(keys[i])) {
+                    std::cerr << "\nwrong order at " << i << "\n";
+                    std::exit(1);
+                }
+            }
+        }
+        std::cout << std::setw(12) << std::fixed << std::setprecision(2)
+                  << best / size;
+    };
+    // the std sorts include packing into and unpacking from structs
+    auto std_sort = [&](auto sort) {
+        return [sort](std::vector<Key> &keys, std::vector<uint32_t> &payload) {
+            std::vector<Pair> pairs(keys.size());
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                pairs[i] = {keys[i], payload[i]};
+            }
+            sort(pairs);
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                keys[i] = pairs[i].first;
+                payload[i] = pairs[i].second;
+            }
+        };
+    };
+    report(std_sort([](std::vector<Pair> &pairs) {
+               std::sort(pairs.begin(), pairs.end(),
+                         [](const Pair &a, const Pair &b) {
+                             return a.first < b.first;
+                         });
+           }),
+           false);
+    report(std_sort([](std::vector<Pair> &pairs) {
+               std::stable_sort(pairs.begin(), pairs.end(),
+                                [](const Pair &a, const Pair &b) {
+                                    return a.first < b.first;
+                                });
+           }),
+           true);
+    report(
+        [](std::vector<Key> &keys, std::vector<uint32_t> &payload) {
+            radix_sort(keys.data(), payload.data(), keys.size());
+        },
+        false);
+    report(
+        [](std::vector<Key> &keys, std::vector<uint32_t> &payload) {
+            radix_sort_stable(keys.data(), payload.data(), keys.size());
+        },
+        true);
+    std::cout << "\n";
+}
+
+int main(int argc, char **argv) {
+    const std::size_t size = argc > 1 ? std::stoul(argv[1]) : 1 << 24;
+    const int repeats = argc > 2 ? std::stoi(argv[2]) : 3;
+    SplitMix64 rng(42);
+
+    std::cout << size << " pairs, " << num_threads()
+              << " threads, best of " << repeats << ", ns per pair\n";
+    std::cout << std::setw(16) << "keys";
+    for (const char *name : {"std::sort", "stable_sort", "radix", "stable"}) {
+        std::cout << std::setw(12) << name;
+    }
+    std::cout << "\n";
+
+    Input<uint32_t> ids{"uint32 < 2^20", std::vector<uint32_t>(size)};
+    Input<uint32_t> wide{"uint32", std::vector<uint32_t>(size)};
+    Input<uint64_t> wide64{"uint64", std::vector<uint64_t>(size)};
+    Input<float> weights{"float [0, 1)", std::vector<float>(size)};
+    Input<float> signed_weights{"float +-1e6", std::vector<float>(size)};
+    Input<double> doubles{"double", std::vector<double>(size)};
+    Input<int32_t> few{"int32 in 16", std::vector<int32_t>(size)};
+    for (std::size_t i = 0; i < size; i++) {
+        ids.keys[i] = rng.next_below(1 << 20);
+        wide.keys[i] = static_cast<uint32_t>(rng());
+        wide64.keys[i] = rng();
+        weights.keys[i] = static_cast<float>(rng.next_double());
+        signed_weights.keys[i] =
+            static_cast<float>((rng.next_double() - 0.5) * 2e6);
+        doubles.keys[i] = rng.next_double() - 0.5;
+        few.keys[i] = static_cast<int32_t>(rng.next_below(16)) - 8;
+    }
+    bench(ids, repeats);
+    bench(wide, repeats);
+    bench(wide64, repeats);
+    bench(weights, repeats);
+    bench(signed_weights, repeats);
+    bench(doubles, repeats);
+    bench(few, repeats);
+    return 0;
+}
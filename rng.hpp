@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+/*
+SplitMix64: a tiny, fast generator with 8 bytes of state.
+
+Parallel kernels seed one generator per task (e.g. per sample or per vertex)
+from a base seed and the task index, so their results depend on the seed only
+and not on the number of threads or the schedule. It satisfies
+UniformRandomBitGenerator and works with the <random> distributions.
+ */
+class SplitMix64 {
+   public:
+    using result_type = uint64_t;
+
+    explicit SplitMix64(uint64_t seed = 0) : state_(seed) {}
+    SplitMix64(uint64_t seed, uint64_t stream)
+        : state_(seed ^ mix(stream + 0x9e3779b97f4a7c15ULL)) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() { return mix(state_ += 0x9e3779b97f4a7c15ULL); }
+
+    // uniform in [0, bound)
+    uint64_t next_below(uint64_t bound) {
+        return static_cast<uint64_t>(
+            (static_cast<unsigned __int128>((*this)()) * bound) >> 64);
+    }
+
+    // uniform in [0, 1)
+    double next_double() { return ((*this)() >> 11) * 0x1.0p-53; }
+
+   private:
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t state_;
+};
@@ -1,48 +1,52 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
-auto SCAN(const std::vector<int> row_ptr, const std::vector<int> col_idx,
-          double eps, int mu) {
+#include "bitmap.hpp"
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "graph_builder.hpp"
+#include "intersect.hpp"
+#include "union_find.hpp"
+
+// requires sorted adjacency lists
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto SCAN(const CSRGraph<VertexId, EdgeOffset, Weight> &graph, double eps,
+          int mu) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
     // << First lambda
     // << Compute the structural similarity between two nodes
-    auto structure_similarity = [&](int source, int target) {
-        auto source_begin = row_ptr[source];
-        auto target_begin = row_ptr[target];
-
-        const auto source_end = row_ptr[source + 1];
-        const auto target_end = row_ptr[target + 1];
-        const auto source_degree = source_end - source_begin;
-        const auto target_degree = target_end - target_begin;
+    auto structure_similarity = [&](VertexId source, VertexId target) {
+        const auto source_degree = graph.degree(source);
+        const auto target_degree = graph.degree(target);
 
         if (source_degree == 0 || target_degree == 0) {
             return 0.0;
         }
 
-        int common_neighbors = 0;
-        while (source_begin < source_end && target_begin < target_end) {
-            if (col_idx[source_begin] == col_idx[target_begin]) {
-                ++common_neighbors;
-                ++source_begin;
-                ++target_begin;
-            } else if (col_idx[source_begin] < col_idx[target_begin]) {
-                ++source_begin;
-            } else {
-                ++target_begin;
-            }
-        }
+        const auto common_neighbors =
+            intersect_count(col_idx + row_ptr[source], source_degree,
+                            col_idx + row_ptr[target], target_degree);
         return static_cast<double>(common_neighbors) /
-               std::sqrt(source_degree * target_degree);
+               std::sqrt(static_cast<double>(source_degree) * target_degree);
     };
     // << Second Functor, DFS
     // << Construct a new cluster from the core node
-    std::function<void(int, std::unordered_set<int> &,
-                       const std::vector<std::unordered_set<int>> &)>
-        dfs =
-            [&dfs](
-                int source, std::unordered_set<int> &new_cluster,
-                const std::vector<std::unordered_set<int>> &strong_neighbors) {
+    std::function<void(VertexId, std::unordered_set<VertexId> &,
+                       const std::vector<std::unordered_set<VertexId>> &)>
+        dfs = [&dfs](VertexId source,
+                     std::unordered_set<VertexId> &new_cluster,
+                     const std::vector<std::unordered_set<VertexId>>
+                         &strong_neighbors) {
                 new_cluster.insert(source);
                 for (const auto target : strong_neighbors[source]) {
                     if (new_cluster.find(target) == new_cluster.end()) {
@@ -52,15 +56,16 @@ auto SCAN(const std::vector<int> row_ptr, const std::vector<int> col_idx,
             };
 
     //>> Find Core Nodes
-    const auto num_nodes = row_ptr.size() - 1;
-    std::vector<std::unordered_set<int>> strong_neighbors(num_nodes);
-    std::unordered_set<int> core_nodes;
-    for (int source = 0; source < num_nodes; source++) {
-        for (int j = row_ptr[source]; j < row_ptr[source + 1]; j++) {
+    const auto num_nodes = graph.num_nodes();
+    std::vector<std::unordered_set<VertexId>> strong_neighbors(num_nodes);
+    std::unordered_set<VertexId> core_nodes;
+    for (std::size_t source = 0; source < num_nodes; source++) {
+        for (auto j = row_ptr[source]; j < row_ptr[source + 1]; j++) {
             auto target = col_idx[j];
             // 1. For each vertex, compute its structural similarity with its
             // neighbors.
-            if (structure_similarity(source, target) > eps) {
+            if (structure_similarity(static_cast<VertexId>(source), target) >
+                eps) {
                 // 2. If the structural similarity is above a certain threshold
                 // (eps), mark the edge as 'strong'.
                 strong_neighbors[source].insert(target);
@@ -68,8 +73,8 @@ auto SCAN(const std::vector<int> row_ptr, const std::vector<int> col_idx,
         }
         // 3. For each vertex, if the number of strong neighbors is above a
         // certain threshold (mu), mark it as a 'core' vertex.
-        if (strong_neighbors[source].size() >= mu) {
-            core_nodes.insert(source);
+        if (strong_neighbors[source].size() >= static_cast<std::size_t>(mu)) {
+            core_nodes.insert(static_cast<VertexId>(source));
         }
     }
     // std::cout << "Strong Neighbors: " << std::endl;
@@ -87,13 +92,13 @@ auto SCAN(const std::vector<int> row_ptr, const std::vector<int> col_idx,
     // std::cout << std::endl;
 
     // >> Find Clusters
-    std::vector<std::unordered_set<int>> clusters;
-    std::unordered_set<int> visited;
+    std::vector<std::unordered_set<VertexId>> clusters;
+    std::unordered_set<VertexId> visited;
     //    4. Perform a DFS to find clusters
     //    starting from each core node
     for (const auto core : core_nodes) {
         if (visited.find(core) == visited.end()) {
-            std::unordered_set<int> new_cluster;
+            std::unordered_set<VertexId> new_cluster;
             dfs(core, new_cluster, strong_neighbors);
             clusters.push_back(new_cluster);
             visited.insert(new_cluster.begin(), new_cluster.end());
@@ -102,17 +107,484 @@ auto SCAN(const std::vector<int> row_ptr, const std::vector<int> col_idx,
     return clusters;
 }
 
-int main() {
+/*
+ * Pruned parallel SCAN, after pSCAN (Chang et al., ICDE 2016) and ppSCAN
+ * (Che et al., ICPP 2018)
+ *
+ * Same similarity and thresholds as SCAN(), but with the usual SCAN cluster
+ * definition: cores joined by strong edges form a cluster, and every non-core
+ * with a strong edge to one of its cores is a member too (a non-core between
+ * clusters belongs to each). SCAN() above also expands clusters through
+ * strong edges between non-cores, so it can report larger clusters.
+ *
+ * Most similarities are never computed:
+ *  - an edge with min(d(u), d(v)) <= eps sqrt(d(u) d(v)) cannot be strong,
+ *  - a vertex stops looking at its edges as soon as it has mu strong ones
+ *    (core) or fewer than mu that still may be strong (non-core),
+ *  - an edge between two cores already in one cluster is skipped,
+ *  - edges between two non-cores are never needed.
+ * Computed results go to two bitmaps aligned with col_idx (decided, strong),
+ * at both directions of the edge. Every undirected edge is computed at most
+ * once: the first pass only computes edges from their smaller end, and an
+ * edge it leaves open has a decided smaller end, so only the larger end can
+ * come back for it.
+ */
+template <typename VertexId>
+struct SCANClusters {
+    // cluster of each core, named by its smallest core; invalid for non-cores
+    std::vector<VertexId> core_cluster;
+    // (cluster, non-core vertex) pairs, sorted
+    std::vector<std::pair<VertexId, VertexId>> non_core_members;
+};
+
+// The pruned kernels find reverse edges with lower_bound and intersect with
+// merges, both of which silently go wrong on unsorted lists
+template <typename VertexId, typename EdgeOffset, typename Weight>
+void check_sorted_adjacency(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph, const char *caller) {
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    bool sorted = true;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(&& : sorted)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        sorted = sorted && std::is_sorted(col_idx + row_ptr[v],
+                                          col_idx + row_ptr[v + 1]);
+    }
+    if (!sorted) {
+        throw std::invalid_argument(
+            std::string(caller) +
+            " requires sorted adjacency lists (see sort_adjacency())");
+    }
+}
+
+// requires sorted adjacency lists
+template <typename VertexId, typename EdgeOffset, typename Weight>
+SCANClusters<VertexId> PrunedSCAN(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph, double eps, int mu) {
+    check_sorted_adjacency(graph, "PrunedSCAN");
+    constexpr VertexId invalid_vertex =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    enum Role : uint8_t { undecided, core, non_core };
+
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const double eps_squared = eps * eps;
+    Bitmap decided(graph.num_edges());
+    Bitmap strong(graph.num_edges());
+    std::vector<uint8_t> role(num_nodes, undecided);
+
+    // degree bound: |N(u) ∩ N(v)| <= min(d(u), d(v))
+    auto may_be_strong = [&](VertexId u, VertexId v) {
+        const double du = graph.degree(u);
+        const double dv = graph.degree(v);
+        return std::min(du, dv) * std::min(du, dv) > eps_squared * du * dv;
+    };
+    // computes the similarity of edge i = (u, v), records it both ways
+    auto compute = [&](VertexId u, EdgeOffset i) {
+        const VertexId v = col_idx[i];
+        const double common =
+            intersect_count(col_idx + row_ptr[u], graph.degree(u),
+                            col_idx + row_ptr[v], graph.degree(v));
+        const bool is_strong = common * common > eps_squared *
+                                                     graph.degree(u) *
+                                                     double(graph.degree(v));
+        const EdgeOffset j =
+            std::lower_bound(col_idx + row_ptr[v], col_idx + row_ptr[v + 1],
+                             u) -
+            col_idx;
+        if (is_strong) {
+            strong.set_bit_atomic(i);
+            strong.set_bit_atomic(j);
+        }
+        decided.set_bit_atomic(i);
+        decided.set_bit_atomic(j);
+        return is_strong;
+    };
+    auto decide = [&](VertexId u, EdgeOffset similar, EdgeOffset possible) {
+        role[u] = similar >= mu ? core : possible < mu ? non_core : undecided;
+        return role[u] != undecided;
+    };
+
+    // >> Core checking
+    // 1. Edges from their smaller end; self loops are always strong
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        EdgeOffset similar = 0, possible = graph.degree(u);
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (v == static_cast<VertexId>(u)) {
+                similar++;
+            } else if (!may_be_strong(u, v)) {
+                possible--;
+            }
+        }
+        if (decide(u, similar, possible)) {
+            continue;
+        }
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (static_cast<std::size_t>(v) > u && may_be_strong(u, v)) {
+                compute(u, i) ? similar++ : possible--;
+                if (decide(u, similar, possible)) {
+                    break;
+                }
+            }
+        }
+    }
+    // 2. The rest for the vertices still undecided, their open edges all
+    //    lead to decided (smaller) vertices
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        if (role[u] != undecided) {
+            continue;
+        }
+        EdgeOffset similar = 0, possible = graph.degree(u);
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (v == static_cast<VertexId>(u)) {
+                similar++;
+            } else if (!may_be_strong(u, v) ||
+                       (decided.get_bit_atomic(i) && !strong.get_bit_atomic(i))) {
+                possible--;
+            } else if (decided.get_bit_atomic(i)) {
+                similar++;
+            }
+        }
+        for (auto i = row_ptr[u];
+             !decide(u, similar, possible) && i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (v != static_cast<VertexId>(u) && !decided.get_bit_atomic(i) &&
+                may_be_strong(u, v)) {
+                compute(u, i) ? similar++ : possible--;
+            }
+        }
+    }
+
+    // >> Clustering
+    // 3. Union the cores along strong edges, from the smaller end
+    std::vector<VertexId> parent(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        parent[v] = v;
+    }
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        if (role[u] != core) {
+            continue;
+        }
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (static_cast<std::size_t>(v) <= u || role[v] != core ||
+                !may_be_strong(u, v)) {
+                continue;
+            }
+            if (decided.get_bit_atomic(i)) {
+                if (strong.get_bit_atomic(i)) {
+                    union_find_link<VertexId>(u, v, parent.data());
+                }
+            } else if (union_find_root<VertexId>(u, parent.data()) !=
+                           union_find_root(v, parent.data()) &&
+                       compute(u, i)) {
+                union_find_link<VertexId>(u, v, parent.data());
+            }
+        }
+    }
+    union_find_compress(num_nodes, parent.data());
+
+    SCANClusters<VertexId> result;
+    result.core_cluster.assign(num_nodes, invalid_vertex);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        if (role[v] == core) {
+            result.core_cluster[v] = parent[v];
+        }
+    }
+    // 4. Attach each non-core to the clusters of its strong core neighbors
+#pragma omp parallel
+    {
+        std::vector<std::pair<VertexId, VertexId>> local_members;
+#pragma omp for schedule(dynamic, 64) nowait
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            if (role[v] != non_core) {
+                continue;
+            }
+            const auto first = local_members.size();
+            for (auto i = row_ptr[v]; i < row_ptr[v + 1]; i++) {
+                const VertexId u = col_idx[i];
+                if (role[u] != core || !may_be_strong(v, u)) {
+                    continue;
+                }
+                if (decided.get_bit_atomic(i) ? strong.get_bit_atomic(i)
+                                              : compute(v, i)) {
+                    local_members.emplace_back(parent[u], v);
+                }
+            }
+            std::sort(local_members.begin() + first, local_members.end());
+            local_members.erase(std::unique(local_members.begin() + first,
+                                            local_members.end()),
+                                local_members.end());
+        }
+#pragma omp critical
+        result.non_core_members.insert(result.non_core_members.end(),
+                                       local_members.begin(),
+                                       local_members.end());
+    }
+    std::sort(result.non_core_members.begin(), result.non_core_members.end());
+    return result;
+}
+
+// Member lists of the clusters, each sorted, ordered by cluster name
+template <typename VertexId>
+std::vector<std::vector<VertexId>> cluster_members(
+    const SCANClusters<VertexId> &clusters) {
+    std::vector<std::pair<VertexId, VertexId>> members =
+        clusters.non_core_members;
+    for (std::size_t v = 0; v < clusters.core_cluster.size(); v++) {
+        if (clusters.core_cluster[v] != static_cast<VertexId>(-1)) {
+            members.emplace_back(clusters.core_cluster[v], v);
+        }
+    }
+    std::sort(members.begin(), members.end());
+    std::vector<std::vector<VertexId>> result;
+    for (std::size_t i = 0; i < members.size(); i++) {
+        if (i == 0 || members[i].first != members[i - 1].first) {
+            result.emplace_back();
+        }
+        result.back().push_back(members[i].second);
+    }
+    return result;
+}
+
+/*
+ * GS*-Index (Wen et al., VLDB 2017)
+ *
+ * Every similarity is computed once at build time. Any (eps, mu) query then
+ * reads only what it reports, in the cluster semantics of PrunedSCAN():
+ *  - neighbor_order: the graph with each list sorted by similarity, highest
+ *    first (ties by id), and the similarities as edge values; the strong
+ *    edges of u at eps are a prefix of its list.
+ *  - core_order: row mu - 1 lists the vertices of degree >= mu by their
+ *    mu-th highest similarity (the eps below which they are cores), highest
+ *    first, so the cores at (eps, mu) are a prefix of row mu - 1. The rows
+ *    add up to num_edges entries.
+ * Both are plain CSR graphs, so save_gs_index() writes them with write_csr()
+ * next to the graph and load_gs_index() maps them back.
+ *
+ * Similarities are stored as float and compared with float(eps).
+ */
+template <typename VertexId, typename EdgeOffset>
+struct GSIndex {
+    CSRGraph<VertexId, EdgeOffset, float> neighbor_order;
+    CSRGraph<VertexId, EdgeOffset> core_order;
+
+    // number of core_order rows, the largest mu with any core
+    std::size_t max_mu() const { return core_order.num_nodes(); }
+};
+
+// requires sorted adjacency lists
+template <typename VertexId, typename EdgeOffset, typename Weight>
+GSIndex<VertexId, EdgeOffset> build_gs_index(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    check_sorted_adjacency(graph, "build_gs_index");
+    const auto *row_ptr = graph.row_ptr();
+    const auto *col_idx = graph.col_idx();
+    const auto num_nodes = graph.num_nodes();
+    const auto num_edges = graph.num_edges();
+
+    // >> Similarities, each undirected edge once from its smaller end
+    std::vector<float> similarity(num_edges);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+            const VertexId v = col_idx[i];
+            if (static_cast<std::size_t>(v) < u) {
+                continue;
+            }
+            const double common =
+                intersect_count(col_idx + row_ptr[u], graph.degree(u),
+                                col_idx + row_ptr[v], graph.degree(v));
+            similarity[i] = static_cast<float>(
+                common / std::sqrt(static_cast<double>(graph.degree(u)) *
+                                   graph.degree(v)));
+            const EdgeOffset j =
+                std::lower_bound(col_idx + row_ptr[v],
+                                 col_idx + row_ptr[v + 1], u) -
+                col_idx;
+            similarity[j] = similarity[i];
+        }
+    }
+
+    // >> Neighbor order
+    std::vector<EdgeOffset> neighbor_ptr(row_ptr, row_ptr + num_nodes + 1);
+    std::vector<VertexId> neighbors(num_edges);
+#pragma omp parallel
+    {
+        std::vector<std::pair<float, VertexId>> list;
+#pragma omp for schedule(dynamic, 64)
+        for (std::size_t u = 0; u < num_nodes; u++) {
+            list.clear();
+            for (auto i = row_ptr[u]; i < row_ptr[u + 1]; i++) {
+                list.emplace_back(-similarity[i], col_idx[i]);
+            }
+            std::sort(list.begin(), list.end());
+            auto i = row_ptr[u];
+            for (const auto &[negated, v] : list) {
+                similarity[i] = -negated;
+                neighbors[i++] = v;
+            }
+        }
+    }
+
+    // >> Core order, row mu - 1 holds the vertices of degree >= mu
+    std::size_t max_degree = 0;
+#pragma omp parallel for reduction(max : max_degree)
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        max_degree = std::max<std::size_t>(max_degree, graph.degree(u));
+    }
+    std::vector<VertexId> by_degree(num_nodes);
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        by_degree[u] = u;
+    }
+    std::stable_sort(by_degree.begin(), by_degree.end(),
+                     [&](VertexId a, VertexId b) {
+                         return graph.degree(a) > graph.degree(b);
+                     });
+    // row mu - 1 starts out as the first (vertices with degree >= mu) of them
+    std::vector<EdgeOffset> core_ptr(max_degree + 1, 0);
+    for (std::size_t u = 0; u < num_nodes; u++) {
+        if (graph.degree(u) > 0) {
+            core_ptr[graph.degree(u)]++;
+        }
+    }
+    for (std::size_t mu = max_degree; mu > 1; mu--) {
+        core_ptr[mu - 1] += core_ptr[mu];
+    }
+    for (std::size_t mu = 1; mu <= max_degree; mu++) {
+        core_ptr[mu] += core_ptr[mu - 1];
+    }
+    std::vector<VertexId> cores(core_ptr[max_degree]);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (std::size_t mu = 1; mu <= max_degree; mu++) {
+        const auto first = cores.begin() + core_ptr[mu - 1];
+        const auto last = cores.begin() + core_ptr[mu];
+        std::copy(by_degree.begin(), by_degree.begin() + (last - first),
+                  first);
+        auto threshold = [&](VertexId v) {
+            return similarity[neighbor_ptr[v] + mu - 1];
+        };
+        std::sort(first, last, [&](VertexId a, VertexId b) {
+            return threshold(a) != threshold(b) ? threshold(a) > threshold(b)
+                                                : a < b;
+        });
+    }
+
+    return {CSRGraph<VertexId, EdgeOffset, float>(std::move(neighbor_ptr),
+                                                  std::move(neighbors),
+                                                  std::move(similarity)),
+            CSRGraph<VertexId, EdgeOffset>(std::move(core_ptr),
+                                           std::move(cores))};
+}
+
+// SCAN clusters at (eps, mu), in time linear in the cores and their strong
+// edges (plus one pass over the vertices to fill core_cluster)
+template <typename VertexId, typename EdgeOffset>
+SCANClusters<VertexId> query_gs_index(
+    const GSIndex<VertexId, EdgeOffset> &index, double eps, int mu) {
+    if (mu < 1) {
+        throw std::invalid_argument("GS*-Index queries need mu >= 1");
+    }
+    constexpr VertexId invalid_vertex =
+        CSRGraph<VertexId, EdgeOffset>::invalid_vertex;
+    const auto &neighbor_order = index.neighbor_order;
+    const auto *similarity = neighbor_order.values();
+    const float threshold = static_cast<float>(eps);
+
+    SCANClusters<VertexId> result;
+    result.core_cluster.assign(neighbor_order.num_nodes(), invalid_vertex);
+    if (static_cast<std::size_t>(mu) > index.max_mu()) {
+        return result;
+    }
+    auto is_core = [&](VertexId v) {
+        return neighbor_order.degree(v) >= mu &&
+               similarity[neighbor_order.row_ptr()[v] + mu - 1] > threshold;
+    };
+    const auto candidates = index.core_order.neighbors(mu - 1);
+    const auto last_core = std::partition_point(
+        candidates.begin(), candidates.end(), [&](VertexId v) { return is_core(v); });
+
+    // >> Cores connected by strong edges, named by their smallest core
+    std::vector<VertexId> component;
+    for (auto core = candidates.begin(); core != last_core; core++) {
+        if (result.core_cluster[*core] != invalid_vertex) {
+            continue;
+        }
+        component.assign(1, *core);
+        result.core_cluster[*core] = *core;
+        const auto first_member = result.non_core_members.size();
+        for (std::size_t head = 0; head < component.size(); head++) {
+            const VertexId u = component[head];
+            const auto neighbors = neighbor_order.neighbors(u);
+            const auto weights = neighbor_order.weights(u);
+            for (std::size_t k = 0; k < neighbors.size() && weights[k] > threshold;
+                 k++) {
+                const VertexId v = neighbors[k];
+                if (!is_core(v)) {
+                    result.non_core_members.emplace_back(invalid_vertex, v);
+                } else if (result.core_cluster[v] == invalid_vertex) {
+                    result.core_cluster[v] = v;
+                    component.push_back(v);
+                }
+            }
+        }
+        const VertexId name = *std::min_element(component.begin(), component.end());
+        for (const auto v : component) {
+            result.core_cluster[v] = name;
+        }
+        for (auto i = first_member; i < result.non_core_members.size(); i++) {
+            result.non_core_members[i].first = name;
+        }
+    }
+    std::sort(result.non_core_members.begin(), result.non_core_members.end());
+    result.non_core_members.erase(std::unique(result.non_core_members.begin(),
+                                              result.non_core_members.end()),
+                                  result.non_core_members.end());
+    return result;
+}
+
+// Writes the index next to the graph file, as <path>.gs-neighbors and
+// <path>.gs-cores in the binary CSR format
+template <typename VertexId, typename EdgeOffset>
+void save_gs_index(const std::string &path,
+                   const GSIndex<VertexId, EdgeOffset> &index) {
+    write_csr(path + ".gs-neighbors", index.neighbor_order);
+    write_csr(path + ".gs-cores", index.core_order);
+}
+
+template <typename VertexId, typename EdgeOffset>
+GSIndex<VertexId, EdgeOffset> load_gs_index(const std::string &path) {
+    return {load_csr<VertexId, EdgeOffset, float>(path + ".gs-neighbors"),
+            load_csr<VertexId, EdgeOffset>(path + ".gs-cores")};
+}
+
+int main(int argc, char **argv) {
     std::vector<int> row_ptr = {0, 4, 8, 12, 16, 17, 21, 25, 29, 33, 34};
     std::vector<int> col_idx = {1, 2, 3, 0, 0, 2, 3, 1, 0, 1, 3, 2,
                                 0, 1, 2, 3, 4, 5, 6, 7, 8, 5, 6, 7,
                                 8, 5, 6, 7, 8, 5, 6, 7, 8, 9};
+    sort_adjacency(row_ptr, col_idx);
 
     // Parameters for SCAN
     double eps = 0.7;
     int mu = 2;
 
-    auto clusters = SCAN(row_ptr, col_idx, eps, mu);
+    CSRGraph<> graph(row_ptr, col_idx);
+    // or load a binary CSR file written by write_csr() (`convert -o` sorts it)
+    if (argc > 1) {
+        graph = load_csr<int, int>(argv[1]);
+    }
+    auto clusters = SCAN(graph, eps, mu);
 
     for (const auto &cluster : clusters) {
         for (const auto node : cluster) {
@@ -120,5 +592,34 @@ int main() {
         }
         std::cout << std::endl;
     }
+
+    std::cout << "Pruned SCAN:" << std::endl;
+    for (const auto &cluster : cluster_members(PrunedSCAN(graph, eps, mu))) {
+        for (const auto node : cluster) {
+            std::cout << node << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    // the index of a loaded graph is kept next to it and reused
+    GSIndex<int, int> index;
+    if (argc > 1 && std::ifstream(std::string(argv[1]) + ".gs-cores")) {
+        index = load_gs_index<int, int>(argv[1]);
+    } else {
+        index = build_gs_index(graph);
+        if (argc > 1) {
+            save_gs_index(argv[1], index);
+        }
+    }
+    for (const double query_eps : {0.5, 0.7, 0.9}) {
+        std::cout << "GS*-Index, eps " << query_eps << ":" << std::endl;
+        for (const auto &cluster :
+             cluster_members(query_gs_index(index, query_eps, mu))) {
+            for (const auto node : cluster) {
+                std::cout << node << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
     return 0;
 }
@@ -1,17 +1,29 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <stack>
 #include <vector>
 
-auto Kosaraju(const std::vector<int> &csr_pointer,
-              const std::vector<int> &csr_index,
-              const std::vector<int> &csc_pointer,
-              const std::vector<int> &csc_index) {
-    const auto num_nodes = csr_pointer.size() - 1;
+#include "bitmap.hpp"
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "transpose.hpp"
+
+// `csc` is the transpose of `csr`
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Kosaraju(const CSRGraph<VertexId, EdgeOffset, Weight> &csr,
+              const CSRGraph<VertexId, EdgeOffset, Weight> &csc) {
+    const auto *csr_pointer = csr.row_ptr();
+    const auto *csr_index = csr.col_idx();
+    const auto *csc_pointer = csc.row_ptr();
+    const auto *csc_index = csc.col_idx();
+    const auto num_nodes = csr.num_nodes();
     std::vector<bool> visited(num_nodes, false);
-    std::stack<int> post_order_stack;
+    std::stack<VertexId> post_order_stack;
     //! First DFS
     // traverse CSR graph
-    std::function<void(int)> dfs_1st = [&](int source) {
+    std::function<void(VertexId)> dfs_1st = [&](VertexId source) {
         visited[source] = true;
         for (auto i = csr_pointer[source]; i < csr_pointer[source + 1]; i++) {
             auto target = csr_index[i];
@@ -22,14 +34,14 @@ auto Kosaraju(const std::vector<int> &csr_pointer,
         post_order_stack.push(source);
     };
 
-    for (int i = 0; i < num_nodes; i++) {
+    for (std::size_t i = 0; i < num_nodes; i++) {
         if (!visited[i]) {
-            dfs_1st(i);
+            dfs_1st(static_cast<VertexId>(i));
         }
     }
     //! Second DFS
-    std::function<void(int, std::vector<int> &)> dfs_2nd =
-        [&](int target, std::vector<int> &SCC) {
+    std::function<void(VertexId, std::vector<VertexId> &)> dfs_2nd =
+        [&](VertexId target, std::vector<VertexId> &SCC) {
             visited[target] = false;
             SCC.push_back(target);
             for (auto i = csc_pointer[target]; i < csc_pointer[target + 1];
@@ -41,13 +53,13 @@ auto Kosaraju(const std::vector<int> &csr_pointer,
             }
         };
     // traverse CSC graph -- backtracking
-    std::vector<std::vector<int>> all_SCCs;
+    std::vector<std::vector<VertexId>> all_SCCs;
     while (!post_order_stack.empty()) {
         auto node = post_order_stack.top();
         post_order_stack.pop();
         if (visited[node])  // go through the visited nodes
         {
-            std::vector<int> SCC;
+            std::vector<VertexId> SCC;
             dfs_2nd(node, SCC);
             all_SCCs.push_back(SCC);
         }
@@ -55,25 +67,33 @@ auto Kosaraju(const std::vector<int> &csr_pointer,
     return all_SCCs;
 }
 
-auto Tarjan(const std::vector<int> &csr_pointer,
-            const std::vector<int> &csr_index) {
-    auto num_nodes = csr_pointer.size() - 1;
+// Uses the graph's cached transpose
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Kosaraju(const CSRGraph<VertexId, EdgeOffset, Weight> &csr) {
+    return Kosaraju(csr, transpose_of(csr));
+}
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto Tarjan(const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *csr_pointer = graph.row_ptr();
+    const auto *csr_index = graph.col_idx();
+    auto num_nodes = graph.num_nodes();
     // The depth-first search order in which the vertices are discovered
     std::vector<int> pre_order(num_nodes, -1);
     //  This represents the smallest pre_order value reachable from vertex [i]
     std::vector<int> low_link(num_nodes, 0);
     std::vector<bool> in_stack(num_nodes, false);
-    std::stack<int> dfs_tree_stack;
-    std::vector<std::vector<int>> all_SCCs;
-
-    std::function<void(int, int, std::vector<int> &, std::vector<int> &,
-                       std::vector<bool> &, std::stack<int> &,
-                       std::vector<std::vector<int>> &)>
-        dfs = [&csr_pointer, &csr_index,
-               &dfs](int source, int count, std::vector<int> &pre_order,
+    std::stack<VertexId> dfs_tree_stack;
+    std::vector<std::vector<VertexId>> all_SCCs;
+
+    std::function<void(VertexId, int &, std::vector<int> &, std::vector<int> &,
+                       std::vector<bool> &, std::stack<VertexId> &,
+                       std::vector<std::vector<VertexId>> &)>
+        dfs = [csr_pointer, csr_index,
+               &dfs](VertexId source, int &count, std::vector<int> &pre_order,
                      std::vector<int> &low_link, std::vector<bool> &in_stack,
-                     std::stack<int> &dfs_tree_stack,
-                     std::vector<std::vector<int>> &all_SCCs) {
+                     std::stack<VertexId> &dfs_tree_stack,
+                     std::vector<std::vector<VertexId>> &all_SCCs) {
             pre_order[source] = count++;
             low_link[source] = pre_order[source];
             in_stack[source] = true;
@@ -103,7 +123,7 @@ auto Tarjan(const std::vector<int> &csr_pointer,
             // descendants, check if current vertex is the root vertex if true,
             // the DFS tree is a SCC
             if (pre_order[source] == low_link[source]) {
-                std::vector<int> scc;
+                std::vector<VertexId> scc;
                 while (true) {
                     auto node = dfs_tree_stack.top();
                     dfs_tree_stack.pop();
@@ -118,42 +138,395 @@ auto Tarjan(const std::vector<int> &csr_pointer,
             }
         };
 
-    for (int i = 0; i < num_nodes; i++) {
+    // shared by the whole search, pre_order numbers must be unique
+    int count = 0;
+    for (std::size_t i = 0; i < num_nodes; i++) {
         if (pre_order[i] == -1) {
-            dfs(i, 0, pre_order, low_link, in_stack, dfs_tree_stack, all_SCCs);
+            dfs(static_cast<VertexId>(i), count, pre_order, low_link,
+                in_stack, dfs_tree_stack, all_SCCs);
         }
     }
 
     return all_SCCs;
 }
 
-int main() {
+/********************
+ * Parallel SCC: trimming + forward-backward + coloring
+ ********************/
+// Groups vertices by component label, components in order of their smallest
+// vertex
+template <typename VertexId>
+std::vector<std::vector<VertexId>> group_components(
+    const std::vector<VertexId> &label) {
+    const std::size_t num_nodes = label.size();
+    std::vector<std::size_t> index(num_nodes, num_nodes);
+    std::vector<std::vector<VertexId>> all_SCCs;
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        auto &slot = index[label[v]];
+        if (slot == num_nodes) {
+            slot = all_SCCs.size();
+            all_SCCs.emplace_back();
+        }
+        all_SCCs[slot].push_back(static_cast<VertexId>(v));
+    }
+    return all_SCCs;
+}
+
+// Level-synchronous BFS from `frontier` along (pointer, index) over the
+// vertices still unassigned in `scc` (and, if given, of the same color as the
+// vertex they are reached from). `on_reach(v, from)` runs once per vertex
+// claimed in `reached`.
+template <typename VertexId, typename EdgeOffset, typename OnReach>
+void scc_reach(const EdgeOffset *pointer, const VertexId *index,
+               std::vector<VertexId> frontier, const std::vector<VertexId> &scc,
+               const VertexId *color, Bitmap &reached, OnReach on_reach) {
+    constexpr auto invalid = static_cast<VertexId>(-1);
+    while (!frontier.empty()) {
+        std::vector<VertexId> next_frontier;
+#pragma omp parallel
+        {
+            std::vector<VertexId> local;
+#pragma omp for schedule(dynamic, 64) nowait
+            for (std::size_t f = 0; f < frontier.size(); f++) {
+                const auto curr = frontier[f];
+                for (auto i = pointer[curr]; i < pointer[curr + 1]; i++) {
+                    const auto next = index[i];
+                    if (scc[next] != invalid ||
+                        (color != nullptr && color[next] != color[curr])) {
+                        continue;
+                    }
+                    if (reached.try_set_bit_atomic(next)) {
+                        on_reach(next, curr);
+                        local.push_back(next);
+                    }
+                }
+            }
+#pragma omp critical
+            next_frontier.insert(next_frontier.end(), local.begin(),
+                                 local.end());
+        }
+        frontier.swap(next_frontier);
+    }
+}
+
+// `csc` is the transpose of `csr`. Every component is labeled by one of its
+// vertices; the phases, all parallel and without recursion, are
+//   1. trimming: peel vertices without live in- or out-edges, they are
+//      singleton SCCs; counters are decremented from a worklist so chains
+//      peel in one pass
+//   2. forward-backward from the pivot with the largest in * out degree: the
+//      intersection of both reachable sets is (usually) the giant SCC
+//   3. coloring for the rest: propagate the minimum vertex id forward until
+//      stable, every vertex still holding its own id is a root, and its SCC
+//      is what reaches it backward within its color; repeat on what is left
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto ParallelSCC(const CSRGraph<VertexId, EdgeOffset, Weight> &csr,
+                 const CSRGraph<VertexId, EdgeOffset, Weight> &csc) {
+    constexpr auto invalid =
+        CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+    const auto *csr_pointer = csr.row_ptr();
+    const auto *csr_index = csr.col_idx();
+    const auto *csc_pointer = csc.row_ptr();
+    const auto *csc_index = csc.col_idx();
+    const std::size_t num_nodes = csr.num_nodes();
+    std::vector<VertexId> scc(num_nodes, invalid);
+
+    //>> Trimming
+    // live degrees without self loops
+    std::vector<EdgeOffset> out_degree(num_nodes), in_degree(num_nodes);
+    std::vector<VertexId> worklist;
+#pragma omp parallel
+    {
+        std::vector<VertexId> local;
+#pragma omp for schedule(dynamic, 1024) nowait
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            EdgeOffset out = 0, in = 0;
+            for (auto i = csr_pointer[v]; i < csr_pointer[v + 1]; i++) {
+                out += csr_index[i] != static_cast<VertexId>(v);
+            }
+            for (auto i = csc_pointer[v]; i < csc_pointer[v + 1]; i++) {
+                in += csc_index[i] != static_cast<VertexId>(v);
+            }
+            out_degree[v] = out;
+            in_degree[v] = in;
+            if (out == 0 || in == 0) {
+                scc[v] = static_cast<VertexId>(v);
+                local.push_back(static_cast<VertexId>(v));
+            }
+        }
+#pragma omp critical
+        worklist.insert(worklist.end(), local.begin(), local.end());
+    }
+    while (!worklist.empty()) {
+        std::vector<VertexId> next_worklist;
+#pragma omp parallel
+        {
+            std::vector<VertexId> local;
+            auto peel = [&](VertexId w, EdgeOffset &degree) {
+                if (fetch_and_add(degree, EdgeOffset(-1)) == 1 &&
+                    compare_and_swap(scc[w], invalid, w)) {
+                    local.push_back(w);
+                }
+            };
+#pragma omp for schedule(dynamic, 64) nowait
+            for (std::size_t k = 0; k < worklist.size(); k++) {
+                const auto v = worklist[k];
+                for (auto i = csr_pointer[v]; i < csr_pointer[v + 1]; i++) {
+                    if (csr_index[i] != v) {
+                        peel(csr_index[i], in_degree[csr_index[i]]);
+                    }
+                }
+                for (auto i = csc_pointer[v]; i < csc_pointer[v + 1]; i++) {
+                    if (csc_index[i] != v) {
+                        peel(csc_index[i], out_degree[csc_index[i]]);
+                    }
+                }
+            }
+#pragma omp critical
+            next_worklist.insert(next_worklist.end(), local.begin(),
+                                 local.end());
+        }
+        worklist.swap(next_worklist);
+    }
+
+    //>> Forward-backward from the pivot
+    VertexId pivot = invalid;
+    double best = -1;
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        const double score = double(in_degree[v]) * double(out_degree[v]);
+        if (scc[v] == invalid && score > best) {
+            best = score;
+            pivot = static_cast<VertexId>(v);
+        }
+    }
+    std::vector<EdgeOffset>().swap(out_degree);
+    std::vector<EdgeOffset>().swap(in_degree);
+    if (pivot != invalid) {
+        Bitmap forward(num_nodes), backward(num_nodes);
+        forward.set_bit(pivot);
+        backward.set_bit(pivot);
+        scc_reach(csr_pointer, csr_index, {pivot}, scc, (VertexId *)nullptr,
+                  forward, [](VertexId, VertexId) {});
+        scc_reach(csc_pointer, csc_index, {pivot}, scc, (VertexId *)nullptr,
+                  backward, [&](VertexId v, VertexId) {
+                      if (forward.get_bit(v)) {
+                          scc[v] = pivot;
+                      }
+                  });
+        scc[pivot] = pivot;
+    }
+
+    //>> Coloring
+    std::vector<VertexId> color(num_nodes);
+    Bitmap changed(num_nodes), next_changed(num_nodes), reached(num_nodes);
+    while (true) {
+        std::size_t num_left = 0;
+#pragma omp parallel for reduction(+ : num_left)
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            color[v] = static_cast<VertexId>(v);
+            if (scc[v] == invalid) {
+                changed.set_bit_atomic(v);
+                num_left++;
+            }
+        }
+        if (num_left == 0) {
+            break;
+        }
+        // forward propagation of the minimum id, only from changed vertices
+        bool any_changed = true;
+        while (any_changed) {
+            any_changed = false;
+            next_changed.reset();
+#pragma omp parallel for reduction(|| : any_changed) schedule(dynamic, 1024)
+            for (std::size_t v = 0; v < num_nodes; v++) {
+                if (!changed.get_bit(v)) {
+                    continue;
+                }
+                const auto c = atomic_load(color[v]);
+                for (auto i = csr_pointer[v]; i < csr_pointer[v + 1]; i++) {
+                    const auto w = csr_index[i];
+                    if (scc[w] == invalid && write_min(color[w], c)) {
+                        next_changed.set_bit_atomic(w);
+                        any_changed = true;
+                    }
+                }
+            }
+            changed.swap(next_changed);
+        }
+        changed.reset();
+        // backward from every root within its color
+        std::vector<VertexId> roots;
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            if (scc[v] == invalid && color[v] == static_cast<VertexId>(v)) {
+                roots.push_back(static_cast<VertexId>(v));
+            }
+        }
+        reached.reset();
+        for (auto r : roots) {
+            reached.set_bit(r);
+        }
+        scc_reach(csc_pointer, csc_index, roots, scc, color.data(), reached,
+                  [&](VertexId v, VertexId) { scc[v] = color[v]; });
+        for (auto r : roots) {
+            scc[r] = r;
+        }
+    }
+    return group_components(scc);
+}
+
+// Uses the graph's cached transpose
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto ParallelSCC(const CSRGraph<VertexId, EdgeOffset, Weight> &csr) {
+    return ParallelSCC(csr, transpose_of(csr));
+}
+
+/********************
+ * Pearce's iterative SCC
+ ********************/
+// Pearce, "A space-efficient algorithm for finding strongly connected
+// components" (IPL 2016). A single array `rindex` replaces Tarjan's pre_order,
+// low_link and in_stack: while a vertex is live it holds the smallest index
+// reachable from it, once its component is complete it holds the component
+// id, counted down from num_nodes - 1. Live indices are handed back when a
+// component completes, so they stay below every finished id and a plain `<`
+// ignores edges into finished components. The recursion becomes an explicit
+// stack of (vertex, next edge) pairs.
+//
+// Returns the component id of every vertex, 0 for the first component found;
+// ids are in reverse topological order of the condensation (sinks first).
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<VertexId> Pearce(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    const auto *csr_pointer = graph.row_ptr();
+    const auto *csr_index = graph.col_idx();
+    const std::size_t num_nodes = graph.num_nodes();
+    std::vector<VertexId> rindex(num_nodes, 0);  // 0 = unvisited
+    std::vector<bool> root(num_nodes, false);
+    std::vector<std::pair<VertexId, EdgeOffset>> call_stack;
+    std::vector<VertexId> component_stack;
+    std::size_t index = 1;
+    std::size_t component = num_nodes - 1;
+
+    auto begin_visiting = [&](VertexId v) {
+        call_stack.emplace_back(v, csr_pointer[v]);
+        root[v] = true;
+        rindex[v] = static_cast<VertexId>(index++);
+    };
+
+    for (std::size_t start = 0; start < num_nodes; start++) {
+        if (rindex[start] != 0) {
+            continue;
+        }
+        begin_visiting(static_cast<VertexId>(start));
+        while (!call_stack.empty()) {
+            auto &[v, next_edge] = call_stack.back();
+            if (next_edge < csr_pointer[v + 1]) {
+                const auto w = csr_index[next_edge];
+                if (rindex[w] == 0) {
+                    // descend; the edge is finished when w returns
+                    begin_visiting(w);
+                    continue;
+                }
+                if (rindex[w] < rindex[v]) {
+                    rindex[v] = rindex[w];
+                    root[v] = false;
+                }
+                next_edge++;
+                continue;
+            }
+            //>> Finish v
+            const VertexId done = v;
+            call_stack.pop_back();
+            if (root[done]) {
+                index--;
+                while (!component_stack.empty() &&
+                       rindex[done] <= rindex[component_stack.back()]) {
+                    rindex[component_stack.back()] =
+                        static_cast<VertexId>(component);
+                    component_stack.pop_back();
+                    index--;
+                }
+                rindex[done] = static_cast<VertexId>(component);
+                component--;
+            } else {
+                component_stack.push_back(done);
+            }
+            if (!call_stack.empty()) {
+                // finish the parent's edge into `done`
+                auto &[parent, parent_edge] = call_stack.back();
+                if (rindex[done] < rindex[parent]) {
+                    rindex[parent] = rindex[done];
+                    root[parent] = false;
+                }
+                parent_edge++;
+            }
+        }
+    }
+    // component ids count down from num_nodes - 1, turn them into 0, 1, ...
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        rindex[v] = static_cast<VertexId>(num_nodes - 1 - rindex[v]);
+    }
+    return rindex;
+}
+
+int main(int argc, char **argv) {
     // CSR representation for the graph
     std::vector<int> csr_pointer = {0, 2, 3, 4, 5, 6};
     std::vector<int> csr_index = {1, 3, 2, 0, 4, 3};
 
-    // CSC representation for the transpose of the graph
-    std::vector<int> csc_pointer = {0, 1, 2, 3, 5, 6};
-    std::vector<int> csc_index = {2, 0, 1, 0, 4, 3};
+    CSRGraph<> csr(csr_pointer, csr_index);
+    // or load a binary CSR file written by write_csr()
+    if (argc > 1) {
+        csr = load_csr<int, int>(argv[1]);
+    }
 
-    auto all_SCCs = Kosaraju2(csr_pointer, csr_index, csc_pointer, csc_index);
+    // both build on the same cached transpose
+    auto all_SCCs = Kosaraju(csr);
 
     for (const auto &scc : all_SCCs) {
         std::cout << "SCC: ";
-        for (int vertex : scc) {
+        for (auto vertex : scc) {
+            std::cout << vertex << " ";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "------------------" << std::endl;
+    all_SCCs = Tarjan(csr);
+    for (const auto &scc : all_SCCs) {
+        std::cout << "SCC: ";
+        for (auto vertex : scc) {
             std::cout << vertex << " ";
         }
         std::cout << std::endl;
     }
     std::cout << "------------------" << std::endl;
-    all_SCCs = Tarjan(csr_pointer, csr_index);
+    all_SCCs = ParallelSCC(csr);
     for (const auto &scc : all_SCCs) {
         std::cout << "SCC: ";
-        for (int vertex : scc) {
+        for (auto vertex : scc) {
             std::cout << vertex << " ";
         }
         std::cout << std::endl;
     }
+    std::cout << "------------------" << std::endl;
+    // one component id per vertex
+    all_SCCs = group_components(Pearce(csr));
+    for (const auto &scc : all_SCCs) {
+        std::cout << "SCC: ";
+        for (auto vertex : scc) {
+            std::cout << vertex << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    // an empty graph has an empty transpose and no components
+    CSRGraph<> empty(std::vector<int>{0}, std::vector<int>{});
+    if (!Kosaraju(empty).empty() || !ParallelSCC(empty).empty() ||
+        transpose(empty).num_nodes() != 0) {
+        std::cerr << "empty graph check failed" << std::endl;
+        return 1;
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -1,31 +1,44 @@
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <vector>
 
-std::vector<int> BellmanFord(const int root, const std::vector<int>& row_pointer,
-                             const std::vector<int>& column_index, const std::vector<float>& weight)
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "parallel.hpp"
+#include "priority_queues.hpp"
+
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<VertexId> BellmanFord(const VertexId root, const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
 {
-  const auto         num_nodes = row_pointer.size() - 1;
-  std::vector<float> distance(num_nodes, std::numeric_limits<float>::max());
-  std::vector<int>   parent(num_nodes, -1);
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "BellmanFord requires a weighted graph");
+  const auto*           row_pointer  = graph.row_ptr();
+  const auto*           column_index = graph.col_idx();
+  const auto*           weight       = graph.values();
+  const auto            num_nodes    = graph.num_nodes();
+  std::vector<Weight>   distance(num_nodes, std::numeric_limits<Weight>::max());
+  std::vector<VertexId> parent(num_nodes, CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex);
 
-  distance[root] = 0.0f;
+  distance[root] = Weight(0);
   // The shortest path between any two vertices in a graph can contain at most num_nodes - 1 edges.
   // If there are more edges in the path, it means there must be a cycle in the path,
   //  hence, num_nodes - 1 iterations of edge relaxation are required
   for(size_t i = 0; i < num_nodes - 1; i++)
   {
-    for(size_t curr = 0; curr < num_nodes; ++curr)
+    for(std::size_t curr = 0; curr < num_nodes; ++curr)
     {
       for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
       {
         const auto next = column_index[j];
         const auto wgt  = weight[j];
-        if(distance[curr] != std::numeric_limits<float>::max()
+        if(distance[curr] != std::numeric_limits<Weight>::max()
            && (distance[curr] + wgt < distance[next]))    // check if curr is valid
         {
           distance[next] = distance[curr] + wgt;
-          parent[next]   = curr;
+          parent[next]   = static_cast<VertexId>(curr);
         }
       }
     }
@@ -37,13 +50,13 @@ std::vector<int> BellmanFord(const int root, const std::vector<int>& row_pointer
   // it implies the presence of a negative-weight cycle in the graph.
   // The reason is that the negative cycle allows you to keep going around it, reducing the distance with each iteration.
   // in the absence of negative-weight cycles, the distance of each vertex should have stabilized after V-1 iterations.
-  for(size_t curr = 0; curr < num_nodes; curr++)
+  for(std::size_t curr = 0; curr < num_nodes; curr++)
   {
     for(auto j = row_pointer[curr]; j < row_pointer[curr + 1]; j++)
     {
       const auto next = column_index[j];
       const auto wgt  = weight[j];
-      if(distance[curr] != std::numeric_limits<float>::max()
+      if(distance[curr] != std::numeric_limits<Weight>::max()
          && (distance[curr] + wgt < distance[next]))
       {
         std::cout << "Negative Cycle Detected\n";
@@ -60,25 +73,38 @@ std::vector<int> BellmanFord(const int root, const std::vector<int>& row_pointer
   return parent;
 }
 
-auto Dijkstra(const int root, const std::vector<int>& row_pointer, const std::vector<int>& column_index,
-              const std::vector<float>& weight)
+// The queue is picked from the weight type (see priority_queues.hpp): a radix
+// heap for integer weights, an indexed 4-ary heap with decrease-key otherwise.
+// DialBuckets suits small integer weights, BinaryHeap is the old lazy-deletion
+// std::priority_queue.
+template <template <typename, typename> class Queue = MonotoneQueue, typename VertexId, typename EdgeOffset,
+          typename Weight>
+auto Dijkstra(const VertexId root, const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
 {
-  const auto         num_nodes = row_pointer.size() - 1;
-  std::vector<float> distance(num_nodes, std::numeric_limits<float>::max());
-  std::vector<int>   parent(num_nodes, -1);
-  std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>,
-                      std::greater<std::pair<float, int>>>
-      min_heap;
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "Dijkstra requires a weighted graph");
+  const auto*           row_pointer  = graph.row_ptr();
+  const auto*           column_index = graph.col_idx();
+  const auto*           weight       = graph.values();
+  const auto            num_nodes    = graph.num_nodes();
+  std::vector<Weight>   distance(num_nodes, std::numeric_limits<Weight>::max());
+  std::vector<VertexId> parent(num_nodes, CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex);
+  Weight                max_weight = Weight(0);
+  if constexpr(Queue<VertexId, Weight>::needs_max_weight)
+  {
+    max_weight = std::accumulate(weight, weight + graph.num_edges(), Weight(0),
+                                 [](Weight a, Weight b) { return std::max(a, b); });
+  }
+  Queue<VertexId, Weight> min_heap(num_nodes, max_weight);
 
-  distance[root] = 0.0f;
-  min_heap.push(std::make_pair(0.0f, root));
+  distance[root] = Weight(0);
+  min_heap.push(root, Weight(0));
 
   while(!min_heap.empty())
   {
-    const auto [dist, curr] = min_heap.top();
-    min_heap.pop();
+    const auto [dist, curr] = min_heap.pop();
     // a shorter path to vertex curr has already been discovered and processed
-    // further exploration of u is unnecessary.
+    // further exploration of u is unnecessary (only queues without decrease-key
+    // hold such stale entries)
     if(dist > distance[curr])
     {
       continue;
@@ -87,12 +113,12 @@ auto Dijkstra(const int root, const std::vector<int>& row_pointer, const std::ve
     {
       const auto next = column_index[i];
       const auto wgt  = weight[i];
-      if(distance[curr] != std::numeric_limits<float>::max()
+      if(distance[curr] != std::numeric_limits<Weight>::max()
          && (distance[curr] + wgt < distance[next]))
       {
         distance[next] = distance[curr] + wgt;
         parent[next]   = curr;
-        min_heap.emplace(distance[next], next);
+        min_heap.push(next, distance[next]);
       }
     }
   }
@@ -105,13 +131,243 @@ auto Dijkstra(const int root, const std::vector<int>& row_pointer, const std::ve
   return parent;
 }
 
-int main()
+// Bucket width for delta-stepping, following Meyer and Sanders: the maximum
+// weight over the average degree, so that a bucket holds about one "hop"
+template <typename VertexId, typename EdgeOffset, typename Weight>
+Weight auto_delta(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  const auto* weight     = graph.values();
+  const auto  num_edges  = static_cast<int64_t>(graph.num_edges());
+  Weight      max_weight = Weight(0);
+#pragma omp parallel for reduction(max : max_weight)
+  for(int64_t i = 0; i < num_edges; i++)
+  {
+    max_weight = std::max(max_weight, weight[i]);
+  }
+  const double average_degree = std::max(1.0, double(num_edges) / std::max<std::size_t>(1, graph.num_nodes()));
+  const auto   delta          = static_cast<Weight>(max_weight / average_degree);
+  return delta > Weight(0) ? delta : Weight(1);
+}
+
+// Recovers a shortest-path tree from final distances: u is a parent of v if
+// distance[u] + w(u, v) == distance[v], which holds exactly because that is
+// how distance[v] was computed. Zero-weight edges are only taken from vertices
+// that already have a parent, one round per zero-weight hop, so ties between
+// equal distances cannot form a cycle.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+std::vector<VertexId> parents_from_distances(const VertexId root, const CSRGraph<VertexId, EdgeOffset, Weight>& graph,
+                                             const std::vector<Weight>& distance)
+{
+  constexpr auto        invalid      = CSRGraph<VertexId, EdgeOffset, Weight>::invalid_vertex;
+  const auto*           row_pointer  = graph.row_ptr();
+  const auto*           column_index = graph.col_idx();
+  const auto*           weight       = graph.values();
+  const auto            num_nodes    = static_cast<int64_t>(graph.num_nodes());
+  std::vector<VertexId> parent(num_nodes, invalid);
+  std::vector<uint8_t>  has_parent(num_nodes, 0);
+  has_parent[root] = 1;
+
+  bool zero_weight_left = false;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(|| : zero_weight_left)
+  for(int64_t curr = 0; curr < num_nodes; curr++)
+  {
+    if(distance[curr] == std::numeric_limits<Weight>::max())
+    {
+      continue;
+    }
+    for(auto i = row_pointer[curr]; i < row_pointer[curr + 1]; i++)
+    {
+      const auto next = column_index[i];
+      if(next != root && distance[curr] + weight[i] == distance[next])
+      {
+        if(weight[i] > Weight(0))
+        {
+          atomic_store(parent[next], static_cast<VertexId>(curr));
+          atomic_store(has_parent[next], uint8_t(1));
+        }
+        else
+        {
+          zero_weight_left = true;
+        }
+      }
+    }
+  }
+  // extend along zero-weight edges
+  for(bool changed = zero_weight_left; changed;)
+  {
+    changed                      = false;
+    std::vector<uint8_t> settled = has_parent;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(|| : changed)
+    for(int64_t curr = 0; curr < num_nodes; curr++)
+    {
+      if(!settled[curr])
+      {
+        continue;
+      }
+      for(auto i = row_pointer[curr]; i < row_pointer[curr + 1]; i++)
+      {
+        const auto next = column_index[i];
+        if(weight[i] == Weight(0) && !settled[next] && distance[curr] == distance[next]
+           && compare_and_swap(has_parent[next], uint8_t(0), uint8_t(1)))
+        {
+          parent[next] = static_cast<VertexId>(curr);
+          changed      = true;
+        }
+      }
+    }
+  }
+  return parent;
+}
+
+/*
+Delta-stepping (Meyer and Sanders, 2003)
+
+Vertices sit in buckets of width delta by tentative distance, and buckets are
+settled in increasing order. Within the current bucket, light edges
+(w <= delta) are relaxed repeatedly, because they can put vertices back into
+the same bucket. The heavy edges of every vertex settled in the bucket are
+relaxed only once, afterwards, because they always land in later buckets.
+All vertices of a bucket are processed in parallel. Distances are lowered with
+an atomic min, and every thread keeps its own bins so that inserting into a
+bucket needs no synchronization. The bins are merged into the shared frontier
+at the end of each phase.
+
+Requires non-negative weights. delta = 0 picks it with auto_delta().
+Returns a parent array in the same format as Dijkstra(). With tied path
+lengths it may be a different, equally valid shortest-path tree.
+ */
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto DeltaStepping(const VertexId root, const CSRGraph<VertexId, EdgeOffset, Weight>& graph, Weight delta = Weight(0))
+{
+  static_assert(CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted, "DeltaStepping requires a weighted graph");
+  constexpr auto    infinity     = std::numeric_limits<Weight>::max();
+  constexpr auto    no_bucket    = std::numeric_limits<std::size_t>::max();
+  const auto*       row_pointer  = graph.row_ptr();
+  const auto*       column_index = graph.col_idx();
+  const auto*       weight       = graph.values();
+  const auto        num_nodes    = graph.num_nodes();
+  if(delta <= Weight(0))
+  {
+    delta = auto_delta(graph);
+  }
+  auto bucket_of = [delta](Weight dist) { return static_cast<std::size_t>(dist / delta); };
+
+  std::vector<Weight>   distance(num_nodes, infinity);
+  std::vector<VertexId> frontier{ root };    // vertices of the current bucket
+  std::vector<VertexId> settled;             // vertices whose heavy edges are due
+  std::size_t           bucket      = 0;
+  std::size_t           next_bucket = 0;
+  std::size_t           shared_size = 0;
+  distance[root]                    = Weight(0);
+
+#pragma omp parallel
+  {
+    std::vector<std::vector<VertexId>> bins;    // this thread's buckets
+    std::vector<VertexId>              local_settled;
+
+    auto relax = [&](VertexId curr, bool light) {
+      const auto dist = atomic_load(distance[curr]);
+      for(auto i = row_pointer[curr]; i < row_pointer[curr + 1]; i++)
+      {
+        if((weight[i] <= delta) != light)
+        {
+          continue;
+        }
+        const auto next     = column_index[i];
+        const auto new_dist = dist + weight[i];
+        if(write_min(distance[next], new_dist))
+        {
+          const auto b = bucket_of(new_dist);
+          if(b >= bins.size())
+          {
+            bins.resize(b + 1);
+          }
+          bins[b].push_back(next);
+        }
+      }
+    };
+    // concatenates every thread's `local` into `shared` and empties `local`
+    auto gather = [&](std::vector<VertexId>& local, std::vector<VertexId>& shared) {
+#pragma omp single
+      shared_size = 0;
+      const auto offset = fetch_and_add(shared_size, local.size());
+#pragma omp barrier
+#pragma omp single
+      shared.resize(shared_size);
+      std::copy(local.begin(), local.end(), shared.begin() + offset);
+      local.clear();
+#pragma omp barrier
+    };
+
+    while(true)
+    {
+      //>> Light edges, until the bucket stays empty
+      while(true)
+      {
+#pragma omp for schedule(dynamic, 64)
+        for(std::size_t i = 0; i < frontier.size(); i++)
+        {
+          const auto curr = frontier[i];
+          if(bucket_of(atomic_load(distance[curr])) != bucket)
+          {
+            continue;    // stale, moved to an earlier bucket since
+          }
+          local_settled.push_back(curr);
+          relax(curr, true);
+        }
+        std::vector<VertexId> empty;
+        gather(bucket < bins.size() ? bins[bucket] : empty, frontier);
+        if(frontier.empty())
+        {
+          break;
+        }
+      }
+      //>> Heavy edges, once per settled vertex
+      gather(local_settled, settled);
+#pragma omp for schedule(dynamic, 64)
+      for(std::size_t i = 0; i < settled.size(); i++)
+      {
+        relax(settled[i], false);
+      }
+      //>> Next non-empty bucket
+#pragma omp single
+      next_bucket = no_bucket;
+      for(auto b = bucket + 1; b < bins.size(); b++)
+      {
+        if(!bins[b].empty())
+        {
+          write_min(next_bucket, b);
+          break;
+        }
+      }
+#pragma omp barrier
+      if(next_bucket == no_bucket)
+      {
+        break;
+      }
+#pragma omp barrier
+#pragma omp single
+      bucket = next_bucket;
+      std::vector<VertexId> empty;
+      gather(bucket < bins.size() ? bins[bucket] : empty, frontier);
+    }
+  }
+  return parents_from_distances(root, graph, distance);
+}
+
+int main(int argc, char** argv)
 {
   std::vector<int>   row_pointer = { 0, 2, 4, 6, 8, 10, 12 };
   std::vector<int>   column_index = { 1, 2, 0, 3, 0, 1, 4, 1, 2, 5, 3, 5 };
   std::vector<float> weight = { 1.2, 2.3, 0.5, 3.1, 4.4, 0.7, 2.8, 1.9, 0.8, 2.0, 1.5, 3.3 };
+  CSRGraph<int, int, float> graph(row_pointer, column_index, weight);
+  // or load a binary CSR file written by write_csr()
+  if(argc > 1)
+  {
+    graph = load_csr<int, int, float>(argv[1]);
+  }
 
-  auto path = BellmanFord(0, row_pointer, column_index, weight);
+  auto path = BellmanFord(0, graph);
 
   if(path.empty())
   {
@@ -127,7 +383,7 @@ int main()
   }
   std::cout << "\n";
 
-  path = Dijkstra(0, row_pointer, column_index, weight);
+  path = Dijkstra(0, graph);
 
   if(path.empty())
   {
@@ -141,6 +397,15 @@ int main()
       std::cout << path[i] << " ";
     }
   }
+  std::cout << "\n";
+
+  path = DeltaStepping(0, graph);
+
+  std::cout << "Path from Root to next: ";
+  for(size_t i = 0; i < path.size(); i++)
+  {
+    std::cout << path[i] << " ";
+  }
 
   return 0;
 }
\ No newline at end of file
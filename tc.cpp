@@ -1,71 +1,425 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <stack>
+#include <stdexcept>
 #include <vector>
 
+#include "csr_graph.hpp"
+#include "csr_io.hpp"
+#include "degeneracy.hpp"
+#include "graph_builder.hpp"
+#include "intersect.hpp"
+#include "parallel.hpp"
+#include "rng.hpp"
+
 // Reference: https://github.com/georgegito/vertexwise-triangle-counting/blob/master/src/v3/v3_seq.cpp
-// allow for parallelism
-auto bfs_tc(const std::vector<int>& row_pointer, const std::vector<int>& column_index)
+// every edge (first, second) with first < second counts the common neighbors
+// of its ends, so each triangle is seen once per edge (require sorted column_index)
+template <typename VertexId, typename EdgeOffset, typename Weight>
+auto bfs_tc(const CSRGraph<VertexId, EdgeOffset, Weight>& graph)
+{
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  uint64_t    numTriangles = 0;
+  const auto  num_nodes    = graph.num_nodes();
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : numTriangles)
+  for(std::size_t first = 0; first < num_nodes; first++)
+  {
+    for(auto i = row_pointer[first]; i < row_pointer[first + 1]; i++)
+    {
+      const auto second = column_index[i];
+      if(static_cast<std::size_t>(second) > first)
+      {
+        numTriangles += intersect_count(column_index + row_pointer[first], graph.degree(first),
+                                        column_index + row_pointer[second], graph.degree(second));
+      }
+    }
+  }
+  return numTriangles / 3;
+}
+
+//------------//
+// DAG triangle counting
+//------------//
+enum class TCOrder
+{
+  Degree,        // low degree -> high degree, ties by id
+  Degeneracy,    // k-core peeling order, out-degree <= degeneracy
+};
+
+struct TriangleCount
 {
-  int        numTriangles = 0;
-  const auto num_nodes  = row_pointer.size() - 1;
-  // check if two nodes have an edge between them with binary search (require sorted column_index)
-  auto intersect = [&](int first, int second) -> bool {
-    // std::find is O(N), assuming the iterator is a forward iterator
-    // auto first_begin = column_index.begin() + row_pointer[first];
-    // auto first_end   = column_index.begin() + row_pointer[first + 1];
-    // std::find(first_begin, first_end, second) != first_end;
-
-    auto first_begin = row_pointer[first];
-    auto first_end   = row_pointer[first + 1] - 1;
-    auto first_mid   = (first_begin + first_end) / 2;
-    while(first_begin <= first_end)
+  uint64_t              total = 0;
+  std::vector<uint64_t> per_vertex;    // triangles through each vertex, if requested
+};
+
+// Keeps every edge u -> v with u before v in the order; lists stay sorted.
+// Self loops vanish since no vertex precedes itself.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+CSRGraph<VertexId, EdgeOffset> orient_dag(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, TCOrder order)
+{
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto  num_nodes    = graph.num_nodes();
+  std::vector<VertexId> rank;
+  if(order == TCOrder::Degeneracy)
+  {
+    rank = degeneracy_rank(graph);
+  }
+  auto precedes = [&](VertexId u, VertexId v) {
+    if(order == TCOrder::Degeneracy)
+    {
+      return rank[u] < rank[v];
+    }
+    const auto degree_u = graph.degree(u);
+    const auto degree_v = graph.degree(v);
+    return degree_u < degree_v || (degree_u == degree_v && u < v);
+  };
+
+  std::vector<EdgeOffset> out_degree(num_nodes);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    EdgeOffset count = 0;
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
+    {
+      count += precedes(static_cast<VertexId>(u), column_index[i]);
+    }
+    out_degree[u] = count;
+  }
+  std::vector<EdgeOffset> dag_pointer = prefix_sum<EdgeOffset>(out_degree);
+  std::vector<VertexId>   dag_index(dag_pointer[num_nodes]);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    auto slot = dag_pointer[u];
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
     {
-      if(column_index[first_mid] == second)
+      if(precedes(static_cast<VertexId>(u), column_index[i]))
       {
-        return true;
+        dag_index[slot++] = column_index[i];
       }
-      else if(column_index[first_mid] < second)
+    }
+  }
+  return { std::move(dag_pointer), std::move(dag_index) };
+}
+
+// Every triangle u < v < w (in the order) is found once, as w in
+// out(u) ∩ out(v) for the DAG edge u -> v. Orienting by degree bounds every
+// out-list by O(sqrt(m)), so hubs no longer dominate. The graph must be
+// undirected with sorted adjacency lists and no duplicate edges.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+TriangleCount dag_tc(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, TCOrder order = TCOrder::Degree,
+                     bool per_vertex = false)
+{
+  const auto  dag         = orient_dag(graph, order);
+  const auto* dag_pointer = dag.row_ptr();
+  const auto* dag_index   = dag.col_idx();
+  const auto  num_nodes   = dag.num_nodes();
+  TriangleCount result;
+  uint64_t      total = 0;
+  if(!per_vertex)
+  {
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : total)
+    for(std::size_t u = 0; u < num_nodes; u++)
+    {
+      for(auto i = dag_pointer[u]; i < dag_pointer[u + 1]; i++)
       {
-        first_begin = first_mid + 1;
+        const auto v = dag_index[i];
+        total += intersect_count(dag_index + dag_pointer[u], dag.degree(u), dag_index + dag_pointer[v],
+                                 dag.degree(v));
       }
-      else
+    }
+    result.total = total;
+    return result;
+  }
+
+  // credit all three corners, w through the materialized intersection
+  result.per_vertex.assign(num_nodes, 0);
+  auto* counts = result.per_vertex.data();
+#pragma omp parallel reduction(+ : total)
+  {
+    std::vector<VertexId> common;
+#pragma omp for schedule(dynamic, 64)
+    for(std::size_t u = 0; u < num_nodes; u++)
+    {
+      uint64_t through_u = 0;
+      for(auto i = dag_pointer[u]; i < dag_pointer[u + 1]; i++)
       {
-        first_end = first_mid - 1;
+        const auto v = dag_index[i];
+        common.resize(std::min(dag.degree(u), dag.degree(v)));
+        const auto found = intersect(dag_index + dag_pointer[u], dag.degree(u), dag_index + dag_pointer[v],
+                                     dag.degree(v), common.data());
+        through_u += found;
+        if(found > 0)
+        {
+          fetch_and_add(counts[v], uint64_t(found));
+        }
+        for(std::size_t k = 0; k < found; k++)
+        {
+          fetch_and_add(counts[common[k]], uint64_t(1));
+        }
       }
-      first_mid = (first_begin + first_end) / 2;
+      fetch_and_add(counts[u], through_u);
+      total += through_u;
     }
-    return false;
+  }
+  result.total = total;
+  return result;
+}
+
+// One Doulion estimate: triangles of a random sparsified copy, scaled by 1 / p^3.
+// Edge {u, v} survives iff a hash of (seed, min, max) falls below p, so both
+// directions agree without coordination.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+double doulion_count(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, double keep_probability, uint64_t seed)
+{
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto  num_nodes    = graph.num_nodes();
+  // p * 2^64 does not fit for p = 1, which keeps every edge anyway
+  const bool  keep_all     = keep_probability >= 1.0;
+  const auto  threshold    = keep_all ? 0 : static_cast<uint64_t>(keep_probability * 0x1.0p64);
+  auto        keep         = [&](uint64_t u, uint64_t v) {
+    return keep_all ||
+           SplitMix64(seed ^ (std::min(u, v) << 32 | std::max(u, v)), std::max(u, v))() < threshold;
   };
+  std::vector<EdgeOffset> degree(num_nodes);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    EdgeOffset count = 0;
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
+    {
+      count += keep(u, column_index[i]);
+    }
+    degree[u] = count;
+  }
+  std::vector<EdgeOffset> sparse_pointer = prefix_sum<EdgeOffset>(degree);
+  std::vector<VertexId>   sparse_index(sparse_pointer[num_nodes]);
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(std::size_t u = 0; u < num_nodes; u++)
+  {
+    auto slot = sparse_pointer[u];
+    for(auto i = row_pointer[u]; i < row_pointer[u + 1]; i++)
+    {
+      if(keep(u, column_index[i]))
+      {
+        sparse_index[slot++] = column_index[i];
+      }
+    }
+  }
+  const CSRGraph<VertexId, EdgeOffset> sparse(std::move(sparse_pointer), std::move(sparse_index));
+  return dag_tc(sparse).total / (keep_probability * keep_probability * keep_probability);
+}
+
+//------------//
+// Approximate triangle counting
+// Estimate the triangle count and the global clustering coefficient from a sample
+//------------//
+enum class TCSampling
+{
+  Wedge,      // Seshadhri-Pinar-Kolda: the closed fraction of uniformly random wedges
+  Doulion     // Tsourakakis et al.: count exactly on a copy that keeps every edge with probability p
+};
+
+struct ApproxTCOptions
+{
+  TCSampling  sampling         = TCSampling::Wedge;
+  double      epsilon          = 0.01;    // target half-width of the interval, relative to the estimate
+  double      delta            = 0.05;    // probability that the interval misses
+  std::size_t max_samples      = 0;       // budget; 0 = 2^26 wedges or 64 Doulion copies
+  double      keep_probability = 0.1;     // Doulion only
+  uint64_t    seed             = 0;
+};
+
+struct ApproxTC
+{
+  double      triangles;
+  double      triangles_low, triangles_high;      // confidence interval
+  double      clustering;                         // 3 * triangles / wedges
+  double      clustering_low, clustering_high;
+  std::size_t samples;                            // wedges or Doulion copies drawn
+};
+
+// z with P(N(0, 1) > z) = tail, by bisection on erfc
+inline double normal_quantile(double tail)
+{
+  double low = 0.0, high = 40.0;
+  for(int it = 0; it < 100; it++)
+  {
+    const double mid = (low + high) / 2;
+    (0.5 * std::erfc(mid / std::sqrt(2.0)) > tail ? low : high) = mid;
+  }
+  return (low + high) / 2;
+}
+
+// Student t quantile with dof degrees of freedom, by the Cornish-Fisher
+// expansion around the normal one; few Doulion copies need the heavier tail
+inline double student_t_quantile(double tail, double dof)
+{
+  const double z  = normal_quantile(tail);
+  const double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+  return z + (z3 + z) / (4 * dof) + (5 * z5 + 16 * z3 + 3 * z) / (96 * dof * dof) +
+         (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * dof * dof * dof);
+}
+
+// Wedges are sampled in doubling batches starting at 1024. Each sample is
+// closed or not, and after every batch the empirical Bernstein bound
+//     sqrt(2 Var[X] ln(3 / d) / k) + 3 ln(3 / d) / k
+// on the closed fraction is the interval half-width; delta is spread over all
+// checks, so the interval stays valid although sampling stops as soon as it is
+// within epsilon of the estimate (or the budget runs out).
+//
+// Doulion keeps every edge with keep_probability (the same coin for both
+// directions), counts the triangles of the copy exactly with dag_tc() and
+// scales by 1 / p^3. Independent copies are drawn in doubling batches until
+// the t interval over their mean is within epsilon; it assumes the copies are
+// roughly normal, so it needs a few of them to mean much.
+//
+// The graph must be undirected with sorted adjacency lists, no duplicate edges
+// and no self loops.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+ApproxTC approx_tc(const CSRGraph<VertexId, EdgeOffset, Weight>& graph, ApproxTCOptions options = {})
+{
+  if(options.sampling == TCSampling::Doulion && !(options.keep_probability > 0 && options.keep_probability <= 1))
+  {
+    throw std::invalid_argument("Doulion needs 0 < keep_probability <= 1");
+  }
+  const auto* row_pointer  = graph.row_ptr();
+  const auto* column_index = graph.col_idx();
+  const auto  num_nodes    = graph.num_nodes();
+  std::vector<uint64_t> wedges(num_nodes);
+#pragma omp parallel for
+  for(std::size_t v = 0; v < num_nodes; v++)
+  {
+    const uint64_t degree = graph.degree(v);
+    wedges[v]             = degree * (degree - (degree > 0)) / 2;
+  }
+  const std::vector<uint64_t> wedge_start = prefix_sum<uint64_t>(wedges);
+  std::vector<uint64_t>().swap(wedges);
+  const double total_wedges = static_cast<double>(wedge_start[num_nodes]);
+  ApproxTC     result{};
+  if(total_wedges == 0)
+  {
+    return result;
+  }
+  const bool        wedge       = options.sampling == TCSampling::Wedge;
+  const std::size_t max_samples = options.max_samples ? options.max_samples : (wedge ? std::size_t(1) << 26 : 64);
+  const std::size_t first_batch = std::min<std::size_t>(max_samples, wedge ? 1024 : 4);
+  const int         num_checks  = 1 + std::max(0.0, std::ceil(std::log2(double(max_samples) / first_batch)));
 
-  for(int first = 0; first < num_nodes; first++)
+  // mean and half-width of the closed fraction (Wedge) or of the count (Doulion)
+  double      mean = 0.0, half_width = 0.0;
+  double      sum = 0.0, sum_squares = 0.0;
+  std::size_t taken = 0;
+  for(std::size_t batch_end = first_batch; taken < max_samples; batch_end *= 2)
   {
-    for(int i = row_pointer[first]; i < row_pointer[first + 1]; i++)
+    batch_end = std::min(batch_end, max_samples);
+    if(wedge)
     {
-      for(int j = i + 1; j < row_pointer[first + 1]; j++)
+      uint64_t closed = 0;
+#pragma omp parallel for reduction(+ : closed)
+      for(int64_t i = taken; i < static_cast<int64_t>(batch_end); i++)
       {
-        const auto second = column_index[i];
-        const auto third  = column_index[j];
-        if(intersect(second, third))
+        SplitMix64 rng(options.seed, i);
+        // the center with probability proportional to its wedges, then two distinct neighbors
+        const auto center = std::upper_bound(wedge_start.begin(), wedge_start.end(),
+                                             rng.next_below(wedge_start[num_nodes])) -
+                            wedge_start.begin() - 1;
+        const auto degree = graph.degree(center);
+        const auto first  = rng.next_below(degree);
+        auto       second = rng.next_below(degree - 1);
+        second += second >= first;
+        auto a = column_index[row_pointer[center] + first];
+        auto b = column_index[row_pointer[center] + second];
+        if(graph.degree(a) > graph.degree(b))
         {
-          numTriangles++;
+          std::swap(a, b);    // search the shorter list
         }
+        closed += std::binary_search(column_index + row_pointer[a], column_index + row_pointer[a + 1], b);
       }
+      sum += closed;
+      sum_squares += closed;
+    }
+    else
+    {
+      for(std::size_t copy = taken; copy < batch_end; copy++)
+      {
+        const double estimate = doulion_count(graph, options.keep_probability, SplitMix64(options.seed, copy)());
+        sum += estimate;
+        sum_squares += estimate * estimate;
+      }
+    }
+    taken = batch_end;
+
+    mean                  = sum / taken;
+    const double variance = std::max(0.0, sum_squares / taken - mean * mean);
+    if(wedge)
+    {
+      const double log_term = std::log(3.0 * num_checks / options.delta);
+      half_width            = std::sqrt(2 * variance * log_term / taken) + 3 * log_term / taken;
+    }
+    else
+    {
+      // sample variance of the copies, two-sided t interval
+      const double spread   = taken > 1 ? std::sqrt(variance * taken / (taken - 1)) : mean;
+      const double quantile = student_t_quantile(options.delta / (2 * num_checks), std::max<double>(1, taken - 1));
+      half_width            = quantile * spread / std::sqrt(double(taken));
+    }
+    if(half_width <= options.epsilon * mean)
+    {
+      break;
     }
   }
-  return numTriangles / 3;
+
+  // a triangle closes three wedges
+  const double to_triangles = wedge ? total_wedges / 3 : 1.0;
+  result.triangles          = mean * to_triangles;
+  result.triangles_low      = std::max(0.0, mean - half_width) * to_triangles;
+  result.triangles_high     = (mean + half_width) * to_triangles;
+  result.clustering         = 3 * result.triangles / total_wedges;
+  result.clustering_low     = 3 * result.triangles_low / total_wedges;
+  result.clustering_high    = std::min(1.0, 3 * result.triangles_high / total_wedges);
+  result.samples            = taken;
+  return result;
 }
 
-int main()
+int main(int argc, char** argv)
 {
   std::vector<int> row_pointer      = { 0, 3, 5, 7, 10, 12, 14 };
   std::vector<int> column_index      = { 1, 2, 3, 0, 2, 0, 1, 0, 4, 5, 3, 5, 3, 4 };
-  const auto       num_nodes = row_pointer.size() - 1;
-  for(int i = 0; i < num_nodes; i++)
+  sort_adjacency(row_pointer, column_index);
+  // unweighted graph for simplicity
+  CSRGraph<> graph(row_pointer, column_index);
+  // or load a binary CSR file written by write_csr() (`convert -o` sorts it)
+  if(argc > 1)
   {
-    std::sort(column_index.begin() + row_pointer[i], column_index.begin() + row_pointer[i + 1]);
+    graph = load_csr<int, int>(argv[1]);
   }
-  // unweighted graph for simplicity
-  auto triangles = bfs_tc(row_pointer, column_index);
+  auto       triangles = bfs_tc(graph);
   std::cout << "number of trianlges: " << triangles << std::endl;
+
+  auto by_degree = dag_tc(graph, TCOrder::Degree, true);
+  std::cout << "degree-ordered DAG: " << by_degree.total << ", per vertex:";
+  for(auto count : by_degree.per_vertex)
+  {
+    std::cout << ' ' << count;
+  }
+  std::cout << "\ndegeneracy-ordered DAG: " << dag_tc(graph, TCOrder::Degeneracy).total << std::endl;
+
+  for(auto sampling : { TCSampling::Wedge, TCSampling::Doulion })
+  {
+    ApproxTCOptions options;
+    options.sampling         = sampling;
+    options.epsilon          = 0.05;
+    options.keep_probability = 0.5;
+    const auto approx        = approx_tc(graph, options);
+    std::cout << (sampling == TCSampling::Wedge ? "wedge sampling: " : "Doulion: ") << approx.triangles << " in ["
+              << approx.triangles_low << ", " << approx.triangles_high << "], clustering " << approx.clustering
+              << " from " << approx.samples << " samples" << std::endl;
+  }
 }
\ No newline at end of file
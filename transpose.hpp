@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+
+/*
+Parallel transpose (CSR -> CSC) and symmetrization.
+
+The edges are cut into one block of consecutive rows per thread, balanced by
+edge count. Each block counts its targets into its own degree histogram, so
+counting needs no atomics; the histograms are then turned into per-block
+write offsets inside every target's list, and each block scatters its edges
+to exactly those slots. Since the blocks and the rows inside them are in
+order, every transposed list comes out sorted by source id, and the result is
+the same for any number of threads.
+
+The histograms take num_blocks * num_nodes offsets; the number of blocks is
+lowered on very sparse graphs so that they never outgrow the edge array.
+ */
+
+namespace transpose_detail {
+
+// First row of each of the num_blocks + 1 blocks, splitting the edges evenly
+template <typename EdgeOffset>
+std::vector<std::size_t> row_blocks(const EdgeOffset *row_ptr,
+                                    std::size_t num_nodes,
+                                    std::size_t num_edges) {
+    if (num_nodes == 0) {
+        return {0, 0};  // one empty block
+    }
+    const std::size_t num_blocks =
+        std::min<std::size_t>(num_threads(), num_edges / num_nodes + 1);
+    std::vector<std::size_t> first(num_blocks + 1, num_nodes);
+    first[0] = 0;
+    for (std::size_t b = 1; b < num_blocks; b++) {
+        const auto split = static_cast<EdgeOffset>(num_edges * b / num_blocks);
+        first[b] = std::upper_bound(row_ptr, row_ptr + num_nodes, split) -
+                   row_ptr - 1;
+        first[b] = std::max(first[b], first[b - 1]);
+    }
+    return first;
+}
+
+}  // namespace transpose_detail
+
+// Returns the transpose of `graph`: u -> v becomes v -> u with the same
+// weight. KeepWeights = false drops the weights. If `edge_ids` is given it
+// receives, for every transposed edge, its index in graph.col_idx().
+template <bool KeepWeights = true, typename VertexId, typename EdgeOffset,
+          typename Weight>
+auto transpose(const CSRGraph<VertexId, EdgeOffset, Weight> &graph,
+               std::vector<EdgeOffset> *edge_ids = nullptr) {
+    using OutWeight = std::conditional_t<KeepWeights, Weight, Unweighted>;
+    constexpr bool with_values = !std::is_same_v<OutWeight, Unweighted>;
+    const auto *row_pointer = graph.row_ptr();
+    const auto *column_index = graph.col_idx();
+    const std::size_t num_nodes = graph.num_nodes();
+    const std::size_t num_edges = graph.num_edges();
+    const auto first =
+        transpose_detail::row_blocks(row_pointer, num_nodes, num_edges);
+    const std::size_t num_blocks = first.size() - 1;
+
+    //>> Per-block degree histograms
+    std::vector<EdgeOffset> histogram(num_blocks * num_nodes, 0);
+#pragma omp parallel for schedule(static, 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        auto *count = histogram.data() + b * num_nodes;
+        for (auto i = row_pointer[first[b]]; i < row_pointer[first[b + 1]];
+             i++) {
+            count[column_index[i]]++;
+        }
+    }
+    // histogram[b][v] becomes the slot of block b inside v's list
+    std::vector<EdgeOffset> in_degree(num_nodes);
+#pragma omp parallel for schedule(static, 4096)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        EdgeOffset running = 0;
+        for (std::size_t b = 0; b < num_blocks; b++) {
+            const auto count = histogram[b * num_nodes + v];
+            histogram[b * num_nodes + v] = running;
+            running += count;
+        }
+        in_degree[v] = running;
+    }
+    std::vector<EdgeOffset> t_row_ptr = prefix_sum<EdgeOffset>(in_degree);
+    std::vector<EdgeOffset>().swap(in_degree);
+
+    //>> Scatter
+    std::vector<VertexId> t_col_idx(num_edges);
+    std::vector<OutWeight> t_values(with_values ? num_edges : 0);
+    if (edge_ids != nullptr) {
+        edge_ids->resize(num_edges);
+    }
+#pragma omp parallel for schedule(static, 1)
+    for (std::size_t b = 0; b < num_blocks; b++) {
+        auto *cursor = histogram.data() + b * num_nodes;
+        for (auto u = first[b]; u < first[b + 1]; u++) {
+            for (auto i = row_pointer[u]; i < row_pointer[u + 1]; i++) {
+                const auto v = column_index[i];
+                const auto slot = t_row_ptr[v] + cursor[v]++;
+                t_col_idx[slot] = static_cast<VertexId>(u);
+                if constexpr (with_values) {
+                    t_values[slot] = graph.values()[i];
+                }
+                if (edge_ids != nullptr) {
+                    (*edge_ids)[slot] = i;
+                }
+            }
+        }
+    }
+    return CSRGraph<VertexId, EdgeOffset, OutWeight>(
+        std::move(t_row_ptr), std::move(t_col_idx), std::move(t_values));
+}
+
+// The transpose kept in the graph's cache: built on the first call, shared by
+// every copy of the graph afterwards
+template <typename VertexId, typename EdgeOffset, typename Weight>
+const CSRGraph<VertexId, EdgeOffset, Weight> &transpose_of(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    return graph.cached_transpose([&] { return transpose(graph); });
+}
+
+// The undirected version of `graph`: the union of its edges and their
+// reverses, every list sorted with duplicates removed (the lightest of
+// parallel edges is kept). Self loops stay, once.
+template <typename VertexId, typename EdgeOffset, typename Weight>
+CSRGraph<VertexId, EdgeOffset, Weight> symmetrize(
+    const CSRGraph<VertexId, EdgeOffset, Weight> &graph) {
+    constexpr bool is_weighted =
+        CSRGraph<VertexId, EdgeOffset, Weight>::is_weighted;
+    const auto &reverse = transpose_of(graph);
+    const std::size_t num_nodes = graph.num_nodes();
+
+    //>> Merge out- and in-lists into slots sized for both
+    std::vector<EdgeOffset> degree(num_nodes);
+#pragma omp parallel for
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        degree[v] = graph.degree(v) + reverse.degree(v);
+    }
+    const std::vector<EdgeOffset> merged_ptr = prefix_sum<EdgeOffset>(degree);
+    std::vector<VertexId> merged_idx(merged_ptr[num_nodes]);
+    std::vector<Weight> merged_values(is_weighted ? merged_idx.size() : 0);
+#pragma omp parallel
+    {
+        std::vector<std::pair<VertexId, Weight>> scratch;
+#pragma omp for schedule(dynamic, 1024)
+        for (std::size_t v = 0; v < num_nodes; v++) {
+            scratch.clear();
+            for (const auto *g : {&graph, &reverse}) {
+                for (auto i = g->row_ptr()[v]; i < g->row_ptr()[v + 1]; i++) {
+                    Weight w{};
+                    if constexpr (is_weighted) {
+                        w = g->values()[i];
+                    }
+                    scratch.emplace_back(g->col_idx()[i], w);
+                }
+            }
+            if constexpr (is_weighted) {
+                std::sort(scratch.begin(), scratch.end());
+            } else {
+                std::sort(scratch.begin(), scratch.end(),
+                          [](const auto &a, const auto &b) {
+                              return a.first < b.first;
+                          });
+            }
+            // a self loop shows up in both lists, this drops the second copy
+            // along with genuine duplicates
+            EdgeOffset kept = 0;
+            for (std::size_t k = 0; k < scratch.size(); k++) {
+                if (k > 0 && scratch[k].first == scratch[k - 1].first) {
+                    continue;
+                }
+                merged_idx[merged_ptr[v] + kept] = scratch[k].first;
+                if constexpr (is_weighted) {
+                    merged_values[merged_ptr[v] + kept] = scratch[k].second;
+                }
+                kept++;
+            }
+            degree[v] = kept;
+        }
+    }
+
+    //>> Compact
+    std::vector<EdgeOffset> row_ptr = prefix_sum<EdgeOffset>(degree);
+    std::vector<VertexId> col_idx(row_ptr[num_nodes]);
+    std::vector<Weight> values(is_weighted ? col_idx.size() : 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        std::copy_n(merged_idx.begin() + merged_ptr[v], degree[v],
+                    col_idx.begin() + row_ptr[v]);
+        if constexpr (is_weighted) {
+            std::copy_n(merged_values.begin() + merged_ptr[v], degree[v],
+                        values.begin() + row_ptr[v]);
+        }
+    }
+    return {std::move(row_ptr), std::move(col_idx), std::move(values)};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+/*
+Lock-free union-find over a plain parent array, for the parallel kernels.
+
+Every vertex starts as its own root (parent[v] = v). A link hooks the larger
+of the two roots under the smaller one with a compare-and-swap, so trees are
+always rooted at their smallest member, parents only ever decrease and no
+rank array is needed. Links may run concurrently with each other; compress()
+runs on its own afterwards and leaves every vertex pointing at its root.
+ */
+
+// Unites the trees of u and v. Returns true if this call did the merge,
+// false if they already were one tree (the caller can use that, e.g. to
+// collect the edges of a spanning forest).
+template <typename VertexId>
+bool union_find_link(VertexId u, VertexId v, VertexId *parent) {
+    VertexId p1 = atomic_load(parent[u]);
+    VertexId p2 = atomic_load(parent[v]);
+    while (p1 != p2) {
+        const VertexId high = std::max(p1, p2);
+        const VertexId low = std::min(p1, p2);
+        const VertexId p_high = atomic_load(parent[high]);
+        if (p_high == low) {
+            return false;
+        }
+        if (p_high == high && compare_and_swap(parent[high], high, low)) {
+            return true;
+        }
+        p1 = atomic_load(parent[atomic_load(parent[high])]);
+        p2 = atomic_load(parent[low]);
+    }
+    return false;
+}
+
+template <typename VertexId>
+VertexId union_find_root(VertexId v, const VertexId *parent) {
+    VertexId p = atomic_load(parent[v]);
+    while (p != v) {
+        v = p;
+        p = atomic_load(parent[v]);
+    }
+    return v;
+}
+
+// Pointer jumping until every vertex points at its root
+template <typename VertexId>
+void union_find_compress(std::size_t num_nodes, VertexId *parent) {
+#pragma omp parallel for schedule(dynamic, 16384)
+    for (std::size_t v = 0; v < num_nodes; v++) {
+        while (parent[v] != parent[parent[v]]) {
+            parent[v] = parent[parent[v]];
+        }
+    }
+}